@@ -0,0 +1,115 @@
+const std = @import("std");
+
+pub fn build(b: *std.Build) void {
+    const target = b.standardTargetOptions(.{});
+    const optimize = b.standardOptimizeOption(.{});
+
+    const cpu = target.result.cpu;
+    const enable_neon = cpu.has(.arm, .neon) or cpu.has(.aarch64, .neon);
+    const enable_sse = cpu.has(.x86, .sse2);
+    // -Dtarget=wasm32-wasi -Dcpu=generic+simd128 builds the web player kernels
+    const enable_wasm_simd = cpu.has(.wasm, .simd128);
+
+    const corpus = b.option(
+        []const u8,
+        "corpus",
+        "Directory with PMD/FMP/S98 files used by the run step (default: bench/corpus)",
+    );
+
+    const mod = b.createModule(.{
+        .target = target,
+        .optimize = optimize,
+        .link_libc = true,
+    });
+
+    mod.addCMacro("_POSIX_C_SOURCE", "200809L");
+    mod.addCMacro("LIBOPNA_ENABLE_PROFILE", "");
+    mod.addIncludePath(b.path(".."));
+    var files: std.ArrayList([]const u8) = .empty;
+    files.appendSlice(b.allocator, &.{
+        "bench/main.c",
+        "common/fmplayer_file.c",
+        "common/fmplayer_file_unix.c",
+        "common/fmplayer_work_opna.c",
+        "common/fmplayer_drumrom_unix.c",
+        "libopna/opnaadpcm.c",
+        "libopna/opnadrum.c",
+        "libopna/opnafm.c",
+        "libopna/opnafm-soa-c.c",
+        "libopna/opnassg.c",
+        "libopna/opnassg-sinc-c.c",
+        "libopna/opnacpu.c",
+        "libopna/opnatimer.c",
+        "libopna/opna.c",
+        "fmdriver/fmdriver_fmp.c",
+        "fmdriver/fmdriver_pmd.c",
+        "fmdriver/fmdriver_common.c",
+        "fmdriver/ppz8.c",
+    }) catch @panic("OOM");
+    if (enable_neon) {
+        mod.addCMacro("ENABLE_NEON", "");
+        files.append(b.allocator, "libopna/opnassg-sinc-neon.s") catch @panic("OOM");
+        files.append(b.allocator, "libopna/opnafm-soa-neon.c") catch @panic("OOM");
+    }
+    if (enable_sse) {
+        mod.addCMacro("ENABLE_SSE", "");
+        files.append(b.allocator, "libopna/opnassg-sinc-sse2.c") catch @panic("OOM");
+        files.append(b.allocator, "libopna/opnafm-soa-sse2.c") catch @panic("OOM");
+        files.append(b.allocator, "fmdriver/ppz8-sinc-sse2.c") catch @panic("OOM");
+        // newer kernels are always built, opna_cpu_select picks them at runtime
+        mod.addCMacro("ENABLE_AVX2", "");
+        mod.addCMacro("ENABLE_AVX512", "");
+    }
+    if (enable_wasm_simd) {
+        mod.addCMacro("ENABLE_WASM_SIMD", "");
+        files.append(b.allocator, "libopna/opnassg-sinc-wasm.c") catch @panic("OOM");
+        files.append(b.allocator, "fmdriver/ppz8-sinc-wasm.c") catch @panic("OOM");
+    }
+    const cflags = [_][]const u8{
+        "-Wall",
+        "-Wextra",
+        "-pedantic",
+        "-std=c99",
+        "-fno-sanitize=shift",
+    };
+    mod.addCSourceFiles(.{
+        .root = b.path(".."),
+        .files = files.items,
+        .flags = &cflags,
+    });
+    if (enable_sse) {
+        mod.addCSourceFiles(.{
+            .root = b.path(".."),
+            .files = &.{
+                "libopna/opnassg-sinc-avx2.c",
+                "libopna/opnafm-soa-avx2.c",
+            },
+            .flags = &(cflags ++ [_][]const u8{"-mavx2"}),
+        });
+        mod.addCSourceFiles(.{
+            .root = b.path(".."),
+            .files = &.{
+                "libopna/opnassg-sinc-avx512.c",
+            },
+            .flags = &(cflags ++ [_][]const u8{ "-mavx512f", "-mavx512bw" }),
+        });
+    }
+
+    const exe = b.addExecutable(.{
+        .name = "98fmbench",
+        .root_module = mod,
+    });
+    b.installArtifact(exe);
+
+    // zig build run [-Dcorpus=DIR] [-- --json]
+    // wasm32-wasi builds run under wasmtime with -fwasmtime
+    const run = b.addRunArtifact(exe);
+    if (b.args) |args| run.addArgs(args);
+    if (corpus) |dir| {
+        run.addArg(dir);
+    } else {
+        run.addDirectoryArg(b.path("corpus"));
+    }
+    const run_step = b.step("run", "Run the benchmark on the corpus");
+    run_step.dependOn(&run.step);
+}
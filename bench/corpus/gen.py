@@ -0,0 +1,187 @@
+#!/usr/bin/env python3
+# Regenerates the benchmark corpus in this directory.
+# usage: gen.py [98fmplayer]
+# PMD4.S98 is recorded with the CLI player, it is skipped if none is given.
+import os, random, struct, subprocess, sys, tempfile
+
+# PMD (.M): 6 FM parts with three repeat blocks each and
+# 3 SSG parts, no rhythm or ADPCM parts
+def pmd_fm_part(base, seed):
+    r = random.Random(seed)
+    out = []
+    def addr(): return base + len(out)
+    # LFO parameters and switch, then the loop point
+    out += [0xf2, 2, 1, 3, 4, 0xf1, 0x01]
+    out += [0xf6]
+    for blk in range(3):
+        # [ ... ]n repeat block, f9 points to f8's count, f8 back to f9
+        f9pos = addr()
+        out += [0xf9, 0, 0]
+        for n in range(r.randint(2, 6)):
+            out += [0x30 + r.randint(0, 0x2b) % 0x0c + 0x10*r.randint(0, 3), r.randint(1, 48)]
+        if r.random() < 0.5:
+            # portamento
+            out += [0xda, 0x40, 0x44, r.randint(2, 30)]
+        f8pos = addr()
+        out += [0xf8, r.randint(2, 4), 0, 0, 0]
+        o = f9pos - base
+        out[o+1:o+3] = list(struct.pack('<H', f8pos+1))
+        o8 = f8pos - base
+        out[o8+3:o8+5] = list(struct.pack('<H', f9pos+1))
+        # rest
+        out += [0x0f, r.randint(1, 20)]
+    out += [0x80]
+    return out
+
+def pmd_ssg_part(base, seed):
+    r = random.Random(seed)
+    # envelope, loop point on half of the parts
+    out = [0xcd, 31, 10, 5, 0x84, 0]
+    if r.random() < 0.5: out += [0xf6]
+    for n in range(r.randint(3, 12)):
+        out += [0x20 + r.randint(0, 11) + 0x10*r.randint(0, 3), r.randint(1, 60)]
+        if r.random() < 0.3: out += [0xf2, 1, 1, 2, 3, 0xf1, 1]
+    out += [0x80]
+    return out
+
+def pmd(seed, ssg=True):
+    parts = []
+    base = 24 + 1  # part table, byte 0 is the (unused) header byte
+    for i in range(12):
+        if i < 6: p = pmd_fm_part(base, seed*100+i)
+        elif i < 9 and ssg: p = pmd_ssg_part(base, seed*100+i)
+        else: p = None
+        if p is None:
+            parts.append(None)
+        else:
+            parts.append((base, p)); base += len(p)
+    empty = base
+    data = bytearray()
+    for x in parts: data += struct.pack('<H', x[0] if x else empty)
+    data += b'\x00'
+    for x in parts:
+        if x: data += bytes(x[1])
+    data += b'\x80\x00'
+    return b'\x00' + bytes(data)
+
+# FMP (.OPI, FMC format 3): 6 FM, 3 SSG, rhythm, ADPCM and 3 extended FM
+# parts with nested loops (some with a break on the last round),
+# tempo/LFO/detune/volume changes and an intro before each loop point
+FMP_PARTS = ['fm']*6 + ['ssg']*3 + ['rhythm', 'adpcm'] + ['fm']*3
+
+def fmp_note_stream(rnd, kind, depth=0):
+    out = []
+    for _ in range(rnd.randint(3, 12)):
+        r = rnd.random()
+        if r < 0.12 and depth < 2:
+            body = fmp_note_stream(rnd, kind, depth+1)
+            cnt = rnd.randint(2, 4)
+            if rnd.random() < 0.5:
+                tail = fmp_note_stream(rnd, kind, depth+1)
+                # 65 dl dh: skip the tail on the last round
+                diff = len(tail) + 5
+                seg = body + [0x65, diff & 0xff, diff >> 8] + tail
+            else:
+                seg = body
+            d = len(seg) + 4
+            out += seg + [0x64, cnt, d & 0xff, d >> 8, cnt]
+            continue
+        if r < 0.2:
+            c = rnd.choice(['tempo', 'q', 'kon', 'det', 'deflen', 'vol', 'lfo', 'tr', 'lfooff', 'pit'])
+            if c == 'tempo': out += [0x62, rnd.randint(0xa0, 0xf0)]
+            elif c == 'q': out += [0x67, rnd.randint(0, 8)]
+            elif c == 'kon': out += [0x6c, rnd.randint(0, 3)]
+            elif c == 'det': out += [0x6d, rnd.randint(0, 255)]
+            elif c == 'deflen': out += [0x72, rnd.randint(4, 48)]
+            elif c == 'vol': out += [0x69, rnd.randint(0, 15)]
+            elif c == 'lfo': out += [0x76, rnd.randint(0, 5), rnd.randint(1, 4), rnd.randint(0, 255), rnd.randint(1, 20), rnd.randint(0, 2)]
+            elif c == 'lfooff': out += [0x75, rnd.choice([0x80|0x20, 0xc0|0x20])]
+            elif c == 'tr': out += [0x7b, rnd.choice([0, 1, 0xff])]
+            elif c == 'pit' and kind != 'adpcm':
+                out += [0x68, rnd.randint(0x10, 0x50), rnd.randint(0, 4), rnd.randint(1, 3), rnd.randint(1, 20)]
+            continue
+        if r < 0.28: out += [rnd.choice([0x66, 0x7a])]
+        if r < 0.4:
+            out += [0x61, rnd.randint(1, 48)]
+        elif r < 0.55:
+            out += [0x80 | rnd.randint(0x10, 0x50)]
+        else:
+            out += [rnd.randint(0x10, 0x50), rnd.randint(1, 96)]
+    return out
+
+def fmp_rhythm_stream(rnd, depth=0):
+    out = []
+    for _ in range(rnd.randint(3, 10)):
+        r = rnd.random()
+        if r < 0.1 and depth < 1:
+            body = fmp_rhythm_stream(rnd, depth+1)
+            cnt = rnd.randint(2, 4)
+            d = len(body) + 4
+            out += body + [0x91, cnt, d & 0xff, d >> 8, cnt]
+        elif r < 0.2:
+            out += [0x90, rnd.randint(4, 48)]
+        elif r < 0.5:
+            out += [0x40 | rnd.randint(0, 0x3f)]
+        else:
+            out += [rnd.randint(0, 0x3f), rnd.randint(1, 96)]
+    return out
+
+# stop_parts: the first stop_parts parts end instead of looping
+def fmp(seed, stop_parts=0):
+    rnd = random.Random(seed)
+    data = bytearray(0x66 + 50)
+    # voice data area, random
+    for i in range(50): data[0x66+i] = rnd.randint(0, 127)
+    ptrs = []
+    loops = []
+    for i, kind in enumerate(FMP_PARTS):
+        if i >= 11 and rnd.random() < 0.5:
+            ptrs.append(0xffff); loops.append(0xffff); continue
+        start = len(data)
+        if kind == 'rhythm':
+            intro = fmp_rhythm_stream(rnd)
+            body = fmp_rhythm_stream(rnd)
+            end = [0x93]
+        else:
+            intro = fmp_note_stream(rnd, kind)
+            body = fmp_note_stream(rnd, kind)
+            end = [0x74]
+        data += bytes(intro)
+        lp = len(data)
+        data += bytes(body) + bytes(end)
+        ptrs.append(start)
+        loops.append(0xffff if i < stop_parts else lp)
+    # PCM file names, SSG tone pointer, signature
+    data += b'\0' * 0x10 + struct.pack('<H', 0xffff)
+    sig = len(data)
+    data += b'FMC' + bytes([0x61]) + b'test\r\n\0'
+    struct.pack_into('<H', data, 0, sig)
+    for i in range(14):
+        struct.pack_into('<H', data, 0x02 + 2*i, ptrs[i])
+        struct.pack_into('<H', data, 0x30 + 2*i, loops[i])
+    data[0x5e] = rnd.choice([96, 128, 192])
+    data[0x5f] = rnd.choice([0, 1])
+    struct.pack_into('<H', data, 0x60, 0xffff)
+    return bytes(data)
+
+def write(name, data):
+    with open(os.path.join(outdir, name), 'wb') as f:
+        f.write(data)
+
+outdir = os.path.dirname(os.path.abspath(__file__))
+write('PMD1.M', pmd(1))
+write('PMD2.M', pmd(4))
+write('PMD3.M', pmd(1, ssg=False))
+write('FMP1.OPI', fmp(0))
+write('FMP2.OPI', fmp(103, stop_parts=3))
+if len(sys.argv) > 1:
+    # one loop of pmd(5), recorded as S98
+    with tempfile.TemporaryDirectory() as tmp:
+        src = os.path.join(tmp, 'PMD4.M')
+        with open(src, 'wb') as f:
+            f.write(pmd(5))
+        subprocess.run([sys.argv[1], '-l', '1', '-o', os.path.join(tmp, 'PMD4.wav'),
+                        '-S', os.path.join(outdir, 'PMD4.S98'), src],
+                       stdout=subprocess.DEVNULL, check=True)
+else:
+    print('98fmplayer not given, PMD4.S98 not regenerated', file=sys.stderr)
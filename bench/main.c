@@ -0,0 +1,674 @@
+#include <dirent.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "common/fmplayer_common.h"
+#include "common/fmplayer_file.h"
+#include "libopna/opna.h"
+#include "libopna/opnatimer.h"
+#include "libopna/opnacpu.h"
+#include "fmdriver/fmdriver.h"
+#include "fmdriver/ppz8.h"
+
+enum {
+  SRATE = 55467,
+  CHANNELS = 2,
+  BLOCK_FRAMES = 1024,
+};
+
+enum {
+  STAGE_FM,
+  STAGE_SSG,
+  STAGE_DRUM,
+  STAGE_ADPCM,
+  STAGE_PPZ8,
+  STAGE_CNT
+};
+
+static const char *stage_names[STAGE_CNT] = {
+  "fm", "ssg", "drum", "adpcm", "ppz8",
+};
+
+static const char *usage =
+  "Usage: %s [OPTION...] FILE|DIR...\n"
+  "Render PMD, FMP or S98 files headless and report rendering speed.\n"
+  "Directories are scanned (not recursively) for song files.\n"
+  "\n"
+  "Options:\n"
+  "  -c, --ppz8-cache=KIB   cache rendered one-shot PPZ8 voices in up to\n"
+  "                         KIB KiB of memory (default: off)\n"
+  "  -f, --float            mix through the int32 bus into float planar\n"
+  "                         output, as the web player does\n"
+  "  -h, --help             show help\n"
+  "  -j, --json             print results in JSON format\n"
+  "  -k, --kernels          time the SSG resampler kernels usable on this\n"
+  "                         CPU instead of rendering files\n"
+  "  -r, --repeat=COUNT     render each file COUNT times and keep the\n"
+  "                         fastest run (default: 1)\n"
+  "  -t, --time=SECONDS     render at most SECONDS of audio per file\n"
+  "                         (default: 180)\n";
+
+static const struct option options[] = {
+  { .name = "ppz8-cache", .has_arg = required_argument, .val = 'c' },
+  { .name = "float",  .has_arg = no_argument,       .val = 'f' },
+  { .name = "help",   .has_arg = no_argument,       .val = 'h' },
+  { .name = "json",   .has_arg = no_argument,       .val = 'j' },
+  { .name = "kernels", .has_arg = no_argument,      .val = 'k' },
+  { .name = "repeat", .has_arg = required_argument, .val = 'r' },
+  { .name = "time",   .has_arg = required_argument, .val = 't' },
+  { 0 },
+};
+
+struct result {
+  const char *path;
+  bool ok;
+  uint64_t frames;
+  // all in ns
+  uint64_t total;
+  uint64_t stage[STAGE_CNT];
+  // FM channel samples skipped as idle, out of frames * 6
+  uint64_t fm_idle;
+  struct ppz8_cache_stats ppz8_cache;
+};
+
+// everything needed to render one file
+struct bench {
+  struct opna opna;
+  struct opna_timer timer;
+  struct ppz8 ppz8;
+  struct fmdriver_work work;
+  struct opna_profile profile;
+  uint64_t ppz8_time;
+  struct ppz8_cache ppz8_cache;
+  uint8_t adpcm_ram[OPNA_ADPCM_RAM_SIZE];
+  float out_l[BLOCK_FRAMES];
+  float out_r[BLOCK_FRAMES];
+};
+
+// shared by all runs, 0 if the PPZ8 cache is off
+static int16_t *ppz8_cache_mem;
+static size_t ppz8_cache_len;
+static bool float_output;
+
+static uint64_t clock_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+static void ppz8_mix_cb(void *ptr, int16_t *buf, unsigned samples) {
+  struct bench *b = ptr;
+  uint64_t begin = clock_ns();
+  ppz8_mix(&b->ppz8, buf, samples);
+  b->ppz8_time += clock_ns() - begin;
+}
+
+static void ppz8_mix32_cb(void *ptr, int32_t *buf, unsigned samples) {
+  struct bench *b = ptr;
+  uint64_t begin = clock_ns();
+  ppz8_mix32(&b->ppz8, buf, samples);
+  b->ppz8_time += clock_ns() - begin;
+}
+
+static void int_cb_dummy(void *ptr) {
+  (void)ptr;
+}
+
+static void bench_init(struct bench *b) {
+  memset(b, 0, sizeof(*b));
+  fmplayer_init_work_opna(&b->work, &b->ppz8, &b->opna, &b->timer, b->adpcm_ram);
+  opna_ssg_set_mix(&b->opna.ssg, 0x10000);
+  opna_ssg_set_ymf288(&b->opna.ssg, &b->opna.resampler, false);
+  ppz8_set_interpolation(&b->ppz8, PPZ8_INTERP_SINC);
+  if (ppz8_cache_mem) {
+    ppz8_cache_init(&b->ppz8_cache, ppz8_cache_mem, ppz8_cache_len);
+    ppz8_set_cache(&b->ppz8, &b->ppz8_cache);
+  }
+  opna_fm_set_hires_sin(&b->opna.fm, false);
+  opna_fm_set_hires_env(&b->opna.fm, false);
+  opna_timer_set_mix_callback(&b->timer, ppz8_mix_cb, b);
+  opna_timer_set_mix32_callback(&b->timer, ppz8_mix32_cb, b);
+  b->profile.clock = clock_ns;
+  b->opna.profile = &b->profile;
+}
+
+static void bench_mix(struct bench *b, int16_t *buf, unsigned frames) {
+  if (float_output) {
+    opna_timer_mix_f32(&b->timer, b->out_l, b->out_r, frames);
+  } else {
+    memset(buf, 0, frames * CHANNELS * sizeof(int16_t));
+    opna_timer_mix(&b->timer, buf, frames);
+  }
+}
+
+static void bench_result(const struct bench *b, struct result *r, uint64_t frames, uint64_t total) {
+  r->ok = true;
+  r->frames = frames;
+  r->total = total;
+  r->stage[STAGE_FM] = b->profile.time[OPNA_PROFILE_FM];
+  r->stage[STAGE_SSG] = b->profile.time[OPNA_PROFILE_SSG];
+  r->stage[STAGE_DRUM] = b->profile.time[OPNA_PROFILE_DRUM];
+  r->stage[STAGE_ADPCM] = b->profile.time[OPNA_PROFILE_ADPCM];
+  r->stage[STAGE_PPZ8] = b->ppz8_time;
+  r->fm_idle = 0;
+  for (int c = 0; c < 6; c++) r->fm_idle += b->opna.fm.idle_skipped[c];
+  r->ppz8_cache = b->ppz8_cache.stats;
+}
+
+static bool bench_fmfile(struct bench *b, const char *path, uint64_t max_frames, struct result *r) {
+  enum fmplayer_file_error error;
+  struct fmplayer_file *fmfile = fmplayer_file_alloc(path, &error);
+  if (!fmfile) {
+    fprintf(stderr, "%s: cannot load file: %s\n", path, fmplayer_file_strerror(error));
+    return false;
+  }
+  bench_init(b);
+  fmplayer_file_load(&b->work, fmfile, 1);
+  int16_t buf[BLOCK_FRAMES * CHANNELS];
+  uint64_t frames = 0;
+  uint64_t begin = clock_ns();
+  while (frames < max_frames && b->work.loop_cnt < 1) {
+    bench_mix(b, buf, BLOCK_FRAMES);
+    frames += BLOCK_FRAMES;
+  }
+  bench_result(b, r, frames, clock_ns() - begin);
+  fmplayer_file_free(fmfile);
+  return true;
+}
+
+// S98: register dump of one (assumed OPNA) device
+// only device 0 is played
+struct s98 {
+  uint8_t *data;
+  size_t len;
+  size_t pos;
+  uint32_t sync_num;
+  uint32_t sync_den;
+};
+
+static uint32_t read32le(const uint8_t *p) {
+  return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void *readfile(const char *path, size_t *len) {
+  FILE *f = fopen(path, "rb");
+  if (!f) return 0;
+  void *buf = 0;
+  if (fseek(f, 0, SEEK_END)) goto err;
+  long size = ftell(f);
+  if (size < 0) goto err;
+  if (fseek(f, 0, SEEK_SET)) goto err;
+  buf = malloc(size ? size : 1);
+  if (!buf) goto err;
+  if (fread(buf, 1, size, f) != (size_t)size) goto err;
+  fclose(f);
+  *len = size;
+  return buf;
+err:
+  free(buf);
+  fclose(f);
+  return 0;
+}
+
+static bool s98_load(struct s98 *s98, uint8_t *data, size_t len) {
+  if (len < 0x20 || memcmp(data, "S98", 3)) return false;
+  char version = data[3];
+  if (version < '1' || version > '3') return false;
+  if (version == '3' && read32le(data + 0x1c)) {
+    if (len < 0x30) return false;
+    uint32_t type = read32le(data + 0x20);
+    // 2: YM2203, 4: YM2608
+    if (type != 2 && type != 4) return false;
+  }
+  s98->data = data;
+  s98->len = len;
+  s98->pos = read32le(data + 0x14);
+  s98->sync_num = read32le(data + 0x04);
+  s98->sync_den = read32le(data + 0x08);
+  if (!s98->sync_num) s98->sync_num = 10;
+  if (!s98->sync_den) s98->sync_den = 1000;
+  return s98->pos < len;
+}
+
+// returns number of syncs to wait, 0 at end of data
+static uint64_t s98_next(struct s98 *s98, struct opna_timer *timer) {
+  while (s98->pos < s98->len) {
+    uint8_t cmd = s98->data[s98->pos++];
+    switch (cmd) {
+    case 0x00:
+    case 0x01:
+      if (s98->pos + 2 > s98->len) return 0;
+      opna_timer_writereg(timer, (cmd << 8) | s98->data[s98->pos], s98->data[s98->pos+1]);
+      s98->pos += 2;
+      break;
+    case 0xff:
+      return 1;
+    case 0xfe:
+      {
+        uint64_t n = 0;
+        for (int shift = 0; s98->pos < s98->len && shift < 35; shift += 7) {
+          uint8_t c = s98->data[s98->pos++];
+          n |= (uint64_t)(c & 0x7f) << shift;
+          if (!(c & 0x80)) break;
+        }
+        return n + 2;
+      }
+    case 0xfd:
+      return 0;
+    default:
+      // other devices
+      if (cmd < 0x40) {
+        s98->pos += 2;
+        break;
+      }
+      return 0;
+    }
+  }
+  return 0;
+}
+
+static bool bench_s98(struct bench *b, const char *path, uint8_t *data, size_t len,
+                      uint64_t max_frames, struct result *r) {
+  struct s98 s98;
+  if (!s98_load(&s98, data, len)) {
+    fprintf(stderr, "%s: unsupported S98 file\n", path);
+    return false;
+  }
+  bench_init(b);
+  opna_timer_set_int_callback(&b->timer, int_cb_dummy, 0);
+  int16_t buf[BLOCK_FRAMES * CHANNELS];
+  uint64_t frames = 0;
+  // remainder of sync to frame conversion
+  uint64_t frac = 0;
+  uint64_t begin = clock_ns();
+  while (frames < max_frames) {
+    uint64_t syncs = s98_next(&s98, &b->timer);
+    if (!syncs) break;
+    frac += syncs * s98.sync_num * SRATE;
+    uint64_t wait = frac / s98.sync_den;
+    frac %= s98.sync_den;
+    while (wait && frames < max_frames) {
+      unsigned n = wait < BLOCK_FRAMES ? wait : BLOCK_FRAMES;
+      bench_mix(b, buf, n);
+      frames += n;
+      wait -= n;
+    }
+  }
+  bench_result(b, r, frames, clock_ns() - begin);
+  return true;
+}
+
+static bool bench_file(struct bench *b, const char *path, uint64_t max_frames, struct result *r) {
+  size_t len;
+  uint8_t *data = readfile(path, &len);
+  if (!data) {
+    perror(path);
+    return false;
+  }
+  bool ok;
+  if (len >= 3 && !memcmp(data, "S98", 3)) {
+    ok = bench_s98(b, path, data, len, max_frames, r);
+  } else {
+    ok = bench_fmfile(b, path, max_frames, r);
+  }
+  free(data);
+  return ok;
+}
+
+static bool is_song_file(const char *filename) {
+  static const char *exts[] = {
+    ".M", ".M2", ".MZ", ".MP", ".MS", ".OPI", ".OVI", ".OZI", ".S98",
+  };
+  const char *ext = strrchr(filename, '.');
+  if (!ext) return false;
+  for (size_t i = 0; i < sizeof(exts)/sizeof(exts[0]); i++) {
+    if (!strcasecmp(ext, exts[i])) return true;
+  }
+  return false;
+}
+
+struct corpus {
+  char **paths;
+  size_t cnt;
+  size_t cap;
+};
+
+static bool corpus_add(struct corpus *c, const char *dir, const char *name) {
+  if (c->cnt == c->cap) {
+    size_t newcap = c->cap ? c->cap * 2 : 64;
+    char **paths = realloc(c->paths, newcap * sizeof(*paths));
+    if (!paths) return false;
+    c->paths = paths;
+    c->cap = newcap;
+  }
+  size_t len = (dir ? strlen(dir) + 1 : 0) + strlen(name) + 1;
+  char *path = malloc(len);
+  if (!path) return false;
+  snprintf(path, len, "%s%s%s", dir ? dir : "", dir ? "/" : "", name);
+  c->paths[c->cnt++] = path;
+  return true;
+}
+
+static int path_cmp(const void *a, const void *b) {
+  return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+static bool corpus_add_input(struct corpus *c, const char *input) {
+  struct stat st;
+  if (stat(input, &st) || !S_ISDIR(st.st_mode)) return corpus_add(c, 0, input);
+  DIR *dir = opendir(input);
+  if (!dir) {
+    perror(input);
+    return true;
+  }
+  size_t first = c->cnt;
+  const struct dirent *de;
+  bool ok = true;
+  while (ok && (de = readdir(dir))) {
+    if (is_song_file(de->d_name)) ok = corpus_add(c, input, de->d_name);
+  }
+  closedir(dir);
+  // fixed order for comparable output
+  qsort(c->paths + first, c->cnt - first, sizeof(*c->paths), path_cmp);
+  return ok;
+}
+
+static double ns_to_s(uint64_t ns) {
+  return ns / 1e9;
+}
+
+static double realtime(uint64_t frames, uint64_t ns) {
+  return ns ? ((double)frames / SRATE) / ns_to_s(ns) : 0.0;
+}
+
+static double samples_per_sec(uint64_t frames, uint64_t ns) {
+  return ns ? frames / ns_to_s(ns) : 0.0;
+}
+
+static void json_string(const char *s) {
+  putchar('"');
+  for (; *s; s++) {
+    unsigned char c = *s;
+    if (c == '"' || c == '\\') {
+      printf("\\%c", c);
+    } else if (c < 0x20) {
+      printf("\\u%04x", c);
+    } else {
+      putchar(c);
+    }
+  }
+  putchar('"');
+}
+
+static double fm_idle_ratio(const struct result *r) {
+  return r->frames ? (double)r->fm_idle / (r->frames * 6) : 0.0;
+}
+
+static void json_result(const struct result *r) {
+  printf("{\"frames\": %" PRIu64 ", \"seconds\": %.6f, \"samples_per_sec\": %.1f, "
+         "\"realtime\": %.3f, \"stages\": {",
+         r->frames, ns_to_s(r->total), samples_per_sec(r->frames, r->total),
+         realtime(r->frames, r->total));
+  for (int s = 0; s < STAGE_CNT; s++) {
+    printf("%s\"%s\": %.6f", s ? ", " : "", stage_names[s], ns_to_s(r->stage[s]));
+  }
+  printf("}, \"fm_idle_skipped\": %" PRIu64 ", \"fm_idle_ratio\": %.4f",
+         r->fm_idle, fm_idle_ratio(r));
+  if (ppz8_cache_mem) {
+    printf(", \"ppz8_cache\": {\"hits\": %" PRIu64 ", \"misses\": %" PRIu64
+           ", \"evictions\": %" PRIu64 "}",
+           r->ppz8_cache.hits, r->ppz8_cache.misses, r->ppz8_cache.evictions);
+  }
+  printf("}");
+}
+
+static void print_json(const struct result *results, size_t cnt, const struct result *total) {
+  printf("{\n  \"srate\": %d,\n  \"files\": [\n", SRATE);
+  bool first = true;
+  for (size_t i = 0; i < cnt; i++) {
+    if (!results[i].ok) continue;
+    printf("%s    {\"path\": ", first ? "" : ",\n");
+    json_string(results[i].path);
+    printf(", \"result\": ");
+    json_result(&results[i]);
+    printf("}");
+    first = false;
+  }
+  printf("\n  ],\n  \"total\": ");
+  json_result(total);
+  printf("\n}\n");
+}
+
+static void print_row(const char *name, const struct result *r) {
+  printf("%-24.24s %8.1f %8.3f %10.0f %8.1fx",
+         name, (double)r->frames / SRATE, ns_to_s(r->total),
+         samples_per_sec(r->frames, r->total), realtime(r->frames, r->total));
+  for (int s = 0; s < STAGE_CNT; s++) {
+    printf(" %5.1f%%", r->total ? 100.0 * r->stage[s] / r->total : 0.0);
+  }
+  printf("\n");
+}
+
+enum {
+  KERNEL_CALLS = 1 << 18,
+  KERNEL_RUNS = 5,
+};
+
+struct kernel_result {
+  const char *name;
+  double ns;
+  double cycles;
+  bool match;
+};
+
+static uint64_t cycles_now(void) {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+// per-call time of each SSG sinc kernel, output is checked against the C kernel
+static int bench_kernels(bool json) {
+  static int16_t inbuf[OPNA_SSG_SINCTABLELEN*4*2];
+  uint32_t seed = 1;
+  for (size_t i = 0; i < sizeof(inbuf)/sizeof(inbuf[0]); i++) {
+    seed = seed * 1103515245u + 12345u;
+    inbuf[i] = (seed >> 16) & 0x1fff;
+  }
+  unsigned features = opna_cpu_features();
+  struct kernel_result results[8];
+  unsigned cnt = 0;
+  int32_t ref[3];
+  for (unsigned k = 0; k < opna_cpu_ssg_sinc_kernel_cnt && cnt < 8; k++) {
+    const struct opna_cpu_ssg_sinc_kernel *kernel = &opna_cpu_ssg_sinc_kernels[k];
+    if ((kernel->features & features) != kernel->features) continue;
+    struct kernel_result *r = &results[cnt++];
+    *r = (struct kernel_result){.name = kernel->name, .match = true};
+    for (int run = 0; run < KERNEL_RUNS; run++) {
+      int32_t sum[3] = {0};
+      uint64_t begin = clock_ns();
+      uint64_t begin_cycles = cycles_now();
+      for (unsigned i = 0; i < KERNEL_CALLS; i++) {
+        int32_t out[3];
+        kernel->func(i & (OPNA_SSG_SINCTABLELEN*2-1), inbuf, out);
+        for (int c = 0; c < 3; c++) sum[c] += out[c];
+      }
+      uint64_t cycles = cycles_now() - begin_cycles;
+      uint64_t ns = clock_ns() - begin;
+      if (!k && !run) memcpy(ref, sum, sizeof(ref));
+      if (memcmp(ref, sum, sizeof(ref))) r->match = false;
+      double call_ns = (double)ns / KERNEL_CALLS;
+      if (!run || call_ns < r->ns) {
+        r->ns = call_ns;
+        r->cycles = (double)cycles / KERNEL_CALLS;
+      }
+    }
+  }
+  if (json) {
+    printf("{\n  \"kernels\": [\n");
+    for (unsigned i = 0; i < cnt; i++) {
+      printf("    {\"name\": \"%s\", \"ns_per_call\": %.2f, \"cycles_per_call\": %.1f, \"match\": %s}%s\n",
+             results[i].name, results[i].ns, results[i].cycles,
+             results[i].match ? "true" : "false", i + 1 < cnt ? "," : "");
+    }
+    printf("  ]\n}\n");
+  } else {
+    printf("%-8s %10s %12s %8s\n", "kernel", "ns/call", "cycles/call", "speedup");
+    for (unsigned i = 0; i < cnt; i++) {
+      printf("%-8s %10.2f %12.1f %7.2fx%s\n", results[i].name, results[i].ns, results[i].cycles,
+             results[i].ns > 0 ? results[0].ns / results[i].ns : 0.0,
+             results[i].match ? "" : " MISMATCH");
+    }
+    printf("selected: %s\n", opna_cpu_select());
+  }
+  for (unsigned i = 0; i < cnt; i++) {
+    if (!results[i].match) return 1;
+  }
+  return 0;
+}
+
+static void print_table(const struct result *results, size_t cnt, const struct result *total) {
+  printf("%-24s %8s %8s %10s %9s", "file", "audio(s)", "time(s)", "samples/s", "realtime");
+  for (int s = 0; s < STAGE_CNT; s++) printf(" %6s", stage_names[s]);
+  printf("\n");
+  for (size_t i = 0; i < cnt; i++) {
+    const char *name = strrchr(results[i].path, '/');
+    name = name ? name + 1 : results[i].path;
+    if (results[i].ok) {
+      print_row(name, &results[i]);
+    } else {
+      printf("%-24.24s failed\n", name);
+    }
+  }
+  print_row("total", total);
+  printf("fm idle: %.1f%% of channel samples skipped\n", 100.0 * fm_idle_ratio(total));
+  if (ppz8_cache_mem) {
+    printf("ppz8 cache: %" PRIu64 " hits, %" PRIu64 " misses, %" PRIu64 " evictions\n",
+           total->ppz8_cache.hits, total->ppz8_cache.misses, total->ppz8_cache.evictions);
+  }
+}
+
+int main(int argc, char **argv) {
+  opna_cpu_select();
+
+  bool json = false;
+  bool kernels = false;
+  int repeat = 1;
+  double max_seconds = 180;
+  long ppz8_cache_kib = 0;
+
+  int optchar;
+  while ((optchar = getopt_long(argc, argv, "c:fhjkr:t:", options, 0)) != -1) {
+    switch (optchar) {
+    case 'c':
+      ppz8_cache_kib = atol(optarg);
+      break;
+    case 'f':
+      float_output = true;
+      break;
+    case 'h':
+      fprintf(stderr, usage, argv[0]);
+      return 0;
+    case 'j':
+      json = true;
+      break;
+    case 'k':
+      kernels = true;
+      break;
+    case 'r':
+      repeat = atoi(optarg);
+      if (repeat < 1) repeat = 1;
+      break;
+    case 't':
+      max_seconds = atof(optarg);
+      break;
+    default:
+      fprintf(stderr, usage, argv[0]);
+      return 1;
+    }
+  }
+  if (kernels) return bench_kernels(json);
+  if (optind >= argc) {
+    fprintf(stderr, usage, argv[0]);
+    return 1;
+  }
+
+  struct corpus corpus = {0};
+  for (int i = optind; i < argc; i++) {
+    if (!corpus_add_input(&corpus, argv[i])) {
+      perror("");
+      return 1;
+    }
+  }
+  if (!corpus.cnt) {
+    fprintf(stderr, "no input files\n");
+    return 1;
+  }
+
+  if (ppz8_cache_kib > 0) {
+    ppz8_cache_len = (size_t)ppz8_cache_kib * 1024 / sizeof(int16_t);
+    ppz8_cache_mem = malloc(ppz8_cache_len * sizeof(int16_t));
+    if (!ppz8_cache_mem) {
+      perror("");
+      return 1;
+    }
+  }
+  struct bench *b = malloc(sizeof(*b));
+  struct result *results = calloc(corpus.cnt, sizeof(*results));
+  if (!b || !results) {
+    perror("");
+    return 1;
+  }
+  uint64_t max_frames = max_seconds * SRATE;
+  struct result total = {.ok = true};
+  bool failed = false;
+  for (size_t i = 0; i < corpus.cnt; i++) {
+    struct result *r = &results[i];
+    r->path = corpus.paths[i];
+    for (int n = 0; n < repeat; n++) {
+      struct result run = {0};
+      if (!bench_file(b, corpus.paths[i], max_frames, &run)) break;
+      if (!r->ok || run.total < r->total) {
+        run.path = r->path;
+        *r = run;
+      }
+    }
+    if (!r->ok) {
+      failed = true;
+      continue;
+    }
+    total.frames += r->frames;
+    total.total += r->total;
+    for (int s = 0; s < STAGE_CNT; s++) total.stage[s] += r->stage[s];
+    total.fm_idle += r->fm_idle;
+    total.ppz8_cache.hits += r->ppz8_cache.hits;
+    total.ppz8_cache.misses += r->ppz8_cache.misses;
+    total.ppz8_cache.evictions += r->ppz8_cache.evictions;
+  }
+
+  if (json) {
+    print_json(results, corpus.cnt, &total);
+  } else {
+    print_table(results, corpus.cnt, &total);
+  }
+
+  for (size_t i = 0; i < corpus.cnt; i++) free(corpus.paths[i]);
+  free(corpus.paths);
+  free(results);
+  free(b);
+  free(ppz8_cache_mem);
+  return failed ? 1 : 0;
+}
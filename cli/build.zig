@@ -32,6 +32,7 @@ pub fn build(b: *std.Build) void {
     files.appendSlice(b.allocator, &.{
         "cli/main.c",
         "common/fmplayer_file.c",
+        "common/fmplayer_seek.c",
         "common/fmplayer_file_unix.c",
         "common/fmplayer_work_opna.c",
         "common/fmplayer_drumrom_unix.c",
@@ -40,7 +41,11 @@ pub fn build(b: *std.Build) void {
         "libopna/opnafm.c",
         "libopna/opnassg.c",
         "libopna/opnassg-sinc-c.c",
+        "libopna/opnacpu.c",
+        "libopna/opnafm-soa-c.c",
         "libopna/opnatimer.c",
+        "libopna/opnaratecvt.c",
+        "libopna/s98rec.c",
         "libopna/opna.c",
         "fmdriver/fmdriver_fmp.c",
         "fmdriver/fmdriver_pmd.c",
@@ -50,22 +55,47 @@ pub fn build(b: *std.Build) void {
     if (enable_neon) {
         mod.addCMacro("ENABLE_NEON", "");
         files.append(b.allocator, "libopna/opnassg-sinc-neon.s") catch @panic("OOM");
+        files.append(b.allocator, "libopna/opnafm-soa-neon.c") catch @panic("OOM");
     }
     if (enable_sse) {
         mod.addCMacro("ENABLE_SSE", "");
         files.append(b.allocator, "libopna/opnassg-sinc-sse2.c") catch @panic("OOM");
+        files.append(b.allocator, "libopna/opnaratecvt-sse2.c") catch @panic("OOM");
+        files.append(b.allocator, "libopna/opnafm-soa-sse2.c") catch @panic("OOM");
+        files.append(b.allocator, "fmdriver/ppz8-sinc-sse2.c") catch @panic("OOM");
+        // newer kernels are always built, opna_cpu_select picks them at runtime
+        mod.addCMacro("ENABLE_AVX2", "");
+        mod.addCMacro("ENABLE_AVX512", "");
     }
+    const cflags = [_][]const u8{
+        "-Wall",
+        "-Wextra",
+        "-pedantic",
+        "-std=c99",
+        "-fno-sanitize=shift",
+    };
     mod.addCSourceFiles(.{
         .root = b.path(".."),
         .files = files.items,
-        .flags = &.{
-            "-Wall",
-            "-Wextra",
-            "-pedantic",
-            "-std=c99",
-            "-fno-sanitize=shift",
-        },
+        .flags = &cflags,
     });
+    if (enable_sse) {
+        mod.addCSourceFiles(.{
+            .root = b.path(".."),
+            .files = &.{
+                "libopna/opnassg-sinc-avx2.c",
+                "libopna/opnafm-soa-avx2.c",
+            },
+            .flags = &(cflags ++ [_][]const u8{"-mavx2"}),
+        });
+        mod.addCSourceFiles(.{
+            .root = b.path(".."),
+            .files = &.{
+                "libopna/opnassg-sinc-avx512.c",
+            },
+            .flags = &(cflags ++ [_][]const u8{ "-mavx512f", "-mavx512bw" }),
+        });
+    }
 
     const exe = b.addExecutable(.{
         .name = "98fmplayer",
@@ -4,10 +4,16 @@
 #include <locale.h>
 #include <setjmp.h>
 #include <stdatomic.h>
+#include <pthread.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <strings.h>
 #include <sys/types.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
 #include <dirent.h>
 #include <fcntl.h>
 #include <getopt.h>
@@ -19,13 +25,18 @@
 
 #include "common/fmplayer_common.h"
 #include "common/fmplayer_file.h"
+#include "common/fmplayer_seek.h"
 #include "libopna/opna.h"
 #include "libopna/opnatimer.h"
+#include "libopna/opnacpu.h"
+#include "libopna/opnaratecvt.h"
+#include "libopna/s98rec.h"
 
 enum {
   SRATE = 55467,
   CHANNELS = 2,
   BLOCK_FRAMES = 1024,
+  PPZ8_CACHE_KIB = 4096,
 };
 
 enum {
@@ -34,25 +45,46 @@ enum {
 };
 
 static const char *usage =
-  "Usage: %s [OPTION...] FILE\n"
+  "Usage: %s [OPTION...] FILE...\n"
   "Play PMD or FMP modules, or compile and play a PMD MML file.\n"
   "\n"
+  "With more than one FILE, or when FILE is a directory, render all PMD/FMP\n"
+  "files in parallel to OUTPUT/NAME.wav (batch mode, OUTPUT is a directory).\n"
+  "\n"
   "Options:\n"
   "  -h, --help           show help\n"
   "  -F, --no-fade        do not fade out at end\n"
   "  -l, --loops=LOOPS    play song LOOPS times (default: 1)\n"
-  "  -o, --output=OUTPUT  write output in WAV format to OUTPUT\n";
+  "  -o, --output=OUTPUT  write output in WAV format to OUTPUT\n"
+  "                       (raw s16le stereo PCM to stdout if OUTPUT is -)\n"
+  "  -j, --jobs=JOBS      use JOBS rendering threads in batch mode\n"
+  "                       (default: number of CPUs)\n"
+  "  -s, --start=SECONDS  start playback SECONDS into the song\n"
+  "  -r, --rate=RATE      output at RATE Hz (44100 to 55467, default: 55467)\n"
+  "  -S, --s98=S98        also record the OPNA register writes to S98\n"
+  "                       (a directory for NAME.s98 in batch mode),\n"
+  "                       PPZ8 is not recorded\n"
+  "  -c, --ppz8-cache=KIB  cache rendered one-shot PPZ8 voices in up to\n"
+  "                       KIB KiB of memory per song (default: 4096, 0: off)\n";
 
 static const struct option options[] = {
   { .name = "help",       .has_arg = no_argument,       .val = 'h' },
   { .name = "no-fade",    .has_arg = no_argument,       .val = 'F' },
   { .name = "loops",      .has_arg = required_argument, .val = 'l' },
   { .name = "output",     .has_arg = required_argument, .val = 'o' },
+  { .name = "jobs",       .has_arg = required_argument, .val = 'j' },
+  { .name = "start",      .has_arg = required_argument, .val = 's' },
+  { .name = "rate",       .has_arg = required_argument, .val = 'r' },
+  { .name = "s98",        .has_arg = required_argument, .val = 'S' },
+  { .name = "ppz8-cache", .has_arg = required_argument, .val = 'c' },
   {},
 };
 
 struct mix_context {
   struct opna_timer *timer;
+  // 0 when output at the native rate
+  struct opna_ratecvt *ratecvt;
+  unsigned srate;
   struct fmdriver_work *work;
   uint64_t volume;
   uint8_t loops;
@@ -62,13 +94,19 @@ struct mix_context {
 
 static bool mix_audio(int16_t *out, size_t frames, struct mix_context *ctx) {
   memset(out, 0, CHANNELS * sizeof(int16_t) * frames);
-  opna_timer_mix(ctx->timer, out, frames);
+  if (ctx->ratecvt) {
+    opna_ratecvt_mix(ctx->ratecvt, ctx->timer, out, frames);
+  } else {
+    opna_timer_mix32(ctx->timer, out, frames);
+  }
   if (ctx->fadeout_enabled && ctx->work->loop_cnt >= ctx->loops) {
+    // same fade length in seconds at any output rate
+    uint64_t fade = (uint64_t)VOLUME_FADE * SRATE / ctx->srate;
     for (unsigned long i = 0; i < frames; i++) {
       int volume = ctx->volume >> 16;
       out[2 * i + 0] = (out[2 * i + 0] * volume) >> 16;
       out[2 * i + 1] = (out[2 * i + 1] * volume) >> 16;
-      ctx->volume = ctx->volume > VOLUME_FADE ? ctx->volume - VOLUME_FADE : 0;
+      ctx->volume = ctx->volume > fade ? ctx->volume - fade : 0;
     }
     return ctx->volume > 0;
   } else {
@@ -196,7 +234,7 @@ static void sjis_to_native(char *out, size_t out_left, const char *sjis) {
   *out = 0;
 }
 
-static void print_comments(struct fmdriver_work *work) {
+static void print_comments(struct fmdriver_work *work, FILE *out) {
   static const char *pmd_comment_titles[] = {
     "Title",
     "Composer",
@@ -206,11 +244,11 @@ static void print_comments(struct fmdriver_work *work) {
     const char *comment = work->get_comment(work, i);
     if (!comment) break;
     if (work->comment_mode_pmd && i < 3) {
-      printf("%s: ", pmd_comment_titles[i]);
+      fprintf(out, "%s: ", pmd_comment_titles[i]);
     }
     char memo[256];
     sjis_to_native(memo, sizeof(memo), comment);
-    printf("%s\n", memo);
+    fprintf(out, "%s\n", memo);
   }
 }
 
@@ -284,7 +322,7 @@ static int play(struct mix_context *ctx) {
   }
   SDL_AudioStream *stream = SDL_OpenAudioDeviceStream(
     SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK,
-    &(SDL_AudioSpec){ .format = SDL_AUDIO_S16, .channels = CHANNELS, .freq = SRATE },
+    &(SDL_AudioSpec){ .format = SDL_AUDIO_S16, .channels = CHANNELS, .freq = ctx->srate },
     audiocb,
     ctx);
   if (!stream) {
@@ -332,143 +370,467 @@ static void w32le(uint8_t *out, uint32_t x) {
   out[3] = x >> 24;
 }
 
-static int save(const char *output, struct mix_context *ctx) {
-  size_t wav_bytes = 0;
-  size_t wav_bytes_cap = 1024 * sizeof(int16_t) * CHANNELS * BLOCK_FRAMES;
-  uint8_t *wav_data = malloc(wav_bytes_cap);
-  if (!wav_data) {
+enum {
+  WAV_HEADER_SIZE = 44,
+  // byte offsets of the sizes patched on close
+  WAV_RIFF_SIZE_OFFSET = 4,
+  WAV_DATA_SIZE_OFFSET = 40,
+  WAV_WRITER_BUF_SIZE = 64 * 1024,
+};
+
+// streaming WAV (or raw PCM) writer
+// header is written first and sizes are patched in wav_writer_close
+struct wav_writer {
+  FILE *file;
+  // no header, s16le stereo only (for stdout)
+  bool raw;
+  unsigned srate;
+  uint64_t data_bytes;
+  size_t buf_len;
+  uint8_t buf[WAV_WRITER_BUF_SIZE];
+};
+
+static void wav_header(uint8_t *out, uint32_t data_bytes, unsigned srate) {
+  memcpy(out + 0, "RIFF", 4);
+  w32le(out + 4, WAV_HEADER_SIZE - 8 + data_bytes);
+  memcpy(out + 8, "WAVE", 4);
+  // Data format chunk
+  memcpy(out + 12, "fmt ", 4);
+  w32le(out + 16, 16);
+  const uint16_t audio_format = 1;
+  w16le(out + 20, audio_format);
+  w16le(out + 22, CHANNELS);
+  w32le(out + 24, srate);
+  uint32_t bytes_per_second = CHANNELS * sizeof(int16_t) * srate;
+  w32le(out + 28, bytes_per_second);
+  uint16_t bytes_per_block = CHANNELS * sizeof(int16_t);
+  w16le(out + 32, bytes_per_block);
+  uint16_t bits_per_sample = sizeof(int16_t) * 8;
+  w16le(out + 34, bits_per_sample);
+  // Data chunk
+  memcpy(out + 36, "data", 4);
+  w32le(out + 40, data_bytes);
+}
+
+// output "-" writes raw PCM to stdout
+static bool wav_writer_open(struct wav_writer *w, const char *output, unsigned srate) {
+  w->srate = srate;
+  w->data_bytes = 0;
+  w->buf_len = 0;
+  w->raw = !strcmp(output, "-");
+  if (w->raw) {
+    w->file = stdout;
+    return true;
+  }
+  w->file = fopen(output, "wb");
+  if (!w->file) return false;
+  // sizes are not known yet, patched in wav_writer_close
+  uint8_t header[WAV_HEADER_SIZE];
+  wav_header(header, UINT32_MAX - WAV_HEADER_SIZE, w->srate);
+  if (fwrite(header, 1, sizeof(header), w->file) < sizeof(header)) {
+    fclose(w->file);
+    return false;
+  }
+  return true;
+}
+
+static bool wav_writer_flush(struct wav_writer *w) {
+  if (!w->buf_len) return true;
+  size_t len = w->buf_len;
+  w->buf_len = 0;
+  return fwrite(w->buf, 1, len, w->file) == len;
+}
+
+static bool wav_writer_write(struct wav_writer *w, const int16_t *samples, size_t frames) {
+  for (size_t i = 0; i < frames * CHANNELS; i++) {
+    if (w->buf_len == sizeof(w->buf)) {
+      if (!wav_writer_flush(w)) return false;
+    }
+    w16le(w->buf + w->buf_len, samples[i]);
+    w->buf_len += 2;
+  }
+  w->data_bytes += frames * CHANNELS * sizeof(int16_t);
+  return true;
+}
+
+static bool wav_writer_close(struct wav_writer *w) {
+  bool ok = wav_writer_flush(w);
+  if (w->raw) {
+    return (fflush(w->file) == 0) && ok;
+  }
+  if (ok) {
+    // the size fields cannot express more than 4GiB
+    uint64_t max_data = UINT32_MAX - (WAV_HEADER_SIZE - 8);
+    uint32_t data_bytes = w->data_bytes > max_data ? max_data : w->data_bytes;
+    uint8_t header[WAV_HEADER_SIZE];
+    wav_header(header, data_bytes, w->srate);
+    ok = !fseek(w->file, WAV_RIFF_SIZE_OFFSET, SEEK_SET) &&
+         fwrite(header + WAV_RIFF_SIZE_OFFSET, 1, 4, w->file) == 4 &&
+         !fseek(w->file, WAV_DATA_SIZE_OFFSET, SEEK_SET) &&
+         fwrite(header + WAV_DATA_SIZE_OFFSET, 1, 4, w->file) == 4;
+  }
+  return (fclose(w->file) == 0) && ok;
+}
+
+// frames: number of written frames, can be NULL
+static int save(const char *output, struct mix_context *ctx, uint64_t *frames) {
+  struct wav_writer *writer = malloc(sizeof(*writer));
+  if (!writer) {
     perror("");
     return 1;
   }
+  if (!wav_writer_open(writer, output, ctx->srate)) {
+    perror("cannot open output file");
+    free(writer);
+    return 1;
+  }
 
+  const char write_err[] = "cannot write to output file";
   int16_t wav_block[CHANNELS * BLOCK_FRAMES];
   bool done = false;
   while (!done) {
     done = !mix_audio(wav_block, BLOCK_FRAMES, ctx);
-
-    if (wav_bytes == wav_bytes_cap) {
-      wav_bytes_cap *= 2;
-      wav_data = realloc(wav_data, wav_bytes_cap);
-      if (!wav_data) {
-        perror("");
-        return 1;
-      }
-    }
-
-    uint8_t *wav_out = wav_data + wav_bytes;
-    for (size_t i = 0; i < CHANNELS * BLOCK_FRAMES; i++) {
-      wav_out[0] = wav_block[i];
-      wav_out[1] = wav_block[i] >> 8;
-      wav_out += 2;
+    if (!wav_writer_write(writer, wav_block, BLOCK_FRAMES)) {
+      perror(write_err);
+      wav_writer_close(writer);
+      free(writer);
+      return 1;
     }
-    wav_bytes += sizeof(int16_t) * CHANNELS * BLOCK_FRAMES;
   }
 
-  FILE *file = fopen(output, "wb");
-  if (!file) {
-    perror("cannot open output file");
+  if (frames) *frames = writer->data_bytes / (CHANNELS * sizeof(int16_t));
+  bool ok = wav_writer_close(writer);
+  free(writer);
+  if (!ok) {
+    perror(write_err);
     return 1;
   }
+  return 0;
+}
 
-  const size_t master_chunk_size = 4 + 4 + 4;
-  const size_t fmt_chunk_size = 4 + 4 + 2 + 2 + 4 + 4 + 2 + 2;
-  const size_t sample_header_size = 4 + 4;
-  const char write_err[] = "cannot write to output file";
-  uint8_t buf[4];
+// everything needed to render one file
+struct render {
+  struct opna opna;
+  struct opna_timer timer;
+  struct ppz8 ppz8;
+  struct fmdriver_work work;
+  struct opna_ratecvt ratecvt;
+  struct s98rec s98rec;
+  struct ppz8_cache ppz8_cache;
+  // ppz8_cache_len samples, 0 if the PPZ8 cache is off
+  int16_t *ppz8_cache_mem;
+  uint8_t adpcm_ram[OPNA_ADPCM_RAM_SIZE];
+};
 
-  // Master RIFF chunk
-  if (fwrite("RIFF", 1, 4, file) < 4) {
-    perror(write_err);
-    return 1;
+// in samples
+static size_t ppz8_cache_len;
+
+static bool s98_file_write(void *userptr, const void *data, size_t len) {
+  return fwrite(data, 1, len, userptr) == len;
+}
+
+// s98file: record the register writes from the start of the song, can be NULL
+// returns false if writing the S98 header failed
+static bool render_init(struct render *r, struct fmplayer_file *fmfile, int loops, FILE *s98file) {
+  fmplayer_init_work_opna(&r->work, &r->ppz8, &r->opna, &r->timer, r->adpcm_ram);
+  opna_ssg_set_mix(&r->opna.ssg, 0x10000);
+  opna_ssg_set_ymf288(&r->opna.ssg, &r->opna.resampler, false);
+  ppz8_set_interpolation(&r->ppz8, PPZ8_INTERP_SINC);
+  if (r->ppz8_cache_mem) {
+    ppz8_cache_init(&r->ppz8_cache, r->ppz8_cache_mem, ppz8_cache_len);
+    ppz8_set_cache(&r->ppz8, &r->ppz8_cache);
+  }
+  opna_fm_set_hires_sin(&r->opna.fm, false);
+  opna_fm_set_hires_env(&r->opna.fm, false);
+  if (s98file) {
+    if (!s98rec_init(&r->s98rec, &r->opna, s98_file_write, s98file)) return false;
+    opna_timer_set_writereg_callback(&r->timer, s98rec_writereg, &r->s98rec);
+  }
+  fmplayer_file_load(&r->work, fmfile, loops);
+  return true;
+}
+
+// ends the recording started by render_init and closes s98file
+static bool render_s98_close(struct render *r, FILE *s98file) {
+  bool ok = s98rec_finish(&r->s98rec);
+  return (fclose(s98file) == 0) && ok;
+}
+
+// skip to seconds into the song without rendering the audio before it
+// returns false if the song ends earlier
+static bool render_start(struct render *r, double seconds) {
+  if (seconds <= 0) return true;
+  return fmplayer_skip(&r->work, &r->timer, (uint64_t)(seconds * SRATE));
+}
+
+// converter for the output rate, 0 for the native rate
+static struct opna_ratecvt *mix_ratecvt(struct render *r, unsigned srate) {
+  if (srate == SRATE) return 0;
+  opna_ratecvt_init(&r->ratecvt, srate);
+  return &r->ratecvt;
+}
+
+static double monotonic_seconds(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+struct batch_job {
+  const char *input;
+  char *output;
+  // NULL when not recording
+  char *s98output;
+  bool ok;
+  uint64_t frames;
+  double seconds;
+};
+
+struct batch {
+  struct batch_job *jobs;
+  size_t job_cnt;
+  atomic_size_t next_job;
+  int loops;
+  bool fade;
+  double start;
+  unsigned srate;
+  // directory for the S98 logs, NULL when not recording
+  const char *s98dir;
+};
+
+static void batch_render(struct render *r, int16_t *ppz8_cache_mem,
+                         struct batch_job *job, const struct batch *batch) {
+  double start = monotonic_seconds();
+  enum fmplayer_file_error fmfile_error;
+  struct fmplayer_file *fmfile = fmplayer_file_alloc(job->input, &fmfile_error);
+  if (!fmfile) {
+    fprintf(stderr, "%s: cannot load file: %s\n", job->input, fmplayer_file_strerror(fmfile_error));
+    return;
   }
-  size_t total_size = master_chunk_size + fmt_chunk_size + sample_header_size + wav_bytes;
-  w32le(buf, total_size - 8);
-  if (fwrite(buf, 1, 4, file) < 4) {
-    perror(write_err);
-    return 1;
+  FILE *s98file = 0;
+  if (job->s98output) {
+    s98file = fopen(job->s98output, "wb");
+    if (!s98file) {
+      perror(job->s98output);
+      fmplayer_file_free(fmfile);
+      return;
+    }
   }
-  if (fwrite("WAVE", 1, 4, file) < 4) {
-    perror(write_err);
-    return 1;
+  memset(r, 0, sizeof(*r));
+  r->ppz8_cache_mem = ppz8_cache_mem;
+  if (!render_init(r, fmfile, batch->loops, s98file)) {
+    perror(job->s98output);
+    fclose(s98file);
+    fmplayer_file_free(fmfile);
+    return;
   }
-
-  // Data format chunk
-  if (fwrite("fmt ", 1, 4, file) < 4) {
-    perror(write_err);
-    return 1;
+  if (!render_start(r, batch->start)) {
+    fprintf(stderr, "%s: start position is past the end of the song\n", job->input);
+    fmplayer_file_free(fmfile);
+    return;
   }
-  size_t chunk_size = fmt_chunk_size - 8;
-  w32le(buf, chunk_size);
-  if (fwrite(buf, 1, 4, file) < 4) {
-    perror(write_err);
-    return 1;
+  struct mix_context ctx = {
+    .timer = &r->timer,
+    .ratecvt = mix_ratecvt(r, batch->srate),
+    .srate = batch->srate,
+    .work = &r->work,
+    .volume = VOLUME_INIT,
+    .loops = batch->loops,
+    .fadeout_enabled = batch->fade,
+  };
+  job->ok = !save(job->output, &ctx, &job->frames);
+  if (s98file && !render_s98_close(r, s98file)) {
+    perror(job->s98output);
+    job->ok = false;
   }
-  const uint16_t audio_format = 1;
-  w16le(buf, audio_format);
-  if (fwrite(buf, 1, 2, file) < 2) {
-    perror(write_err);
-    return 1;
+  job->seconds = monotonic_seconds() - start;
+  fmplayer_file_free(fmfile);
+}
+
+static void *batch_worker(void *ptr) {
+  struct batch *batch = ptr;
+  // struct opna and the ADPCM RAM are too large for thread stacks
+  struct render *r = malloc(sizeof(*r));
+  int16_t *ppz8_cache_mem = 0;
+  if (ppz8_cache_len) ppz8_cache_mem = malloc(ppz8_cache_len * sizeof(int16_t));
+  if (!r || (ppz8_cache_len && !ppz8_cache_mem)) {
+    perror("");
+    free(r);
+    free(ppz8_cache_mem);
+    return 0;
   }
-  w16le(buf, CHANNELS);
-  if (fwrite(buf, 1, 2, file) < 2) {
-    perror(write_err);
-    return 1;
+  for (;;) {
+    size_t i = atomic_fetch_add(&batch->next_job, 1);
+    if (i >= batch->job_cnt) break;
+    batch_render(r, ppz8_cache_mem, &batch->jobs[i], batch);
   }
-  w32le(buf, SRATE);
-  if (fwrite(buf, 1, 4, file) < 4) {
-    perror(write_err);
-    return 1;
+  free(r);
+  free(ppz8_cache_mem);
+  return 0;
+}
+
+static bool is_song_file(const char *filename) {
+  static const char *exts[] = {
+    ".M", ".M2", ".MZ", ".MP", ".MS", ".OPI", ".OVI", ".OZI",
+  };
+  const char *ext = strrchr(filename, '.');
+  if (!ext) return false;
+  for (size_t i = 0; i < sizeof(exts)/sizeof(exts[0]); i++) {
+    if (!strcasecmp(ext, exts[i])) return true;
   }
-  uint32_t bytes_per_second = CHANNELS * sizeof(int16_t) * SRATE;
-  w32le(buf, bytes_per_second);
-  if (fwrite(buf, 1, 4, file) < 4) {
-    perror(write_err);
-    return 1;
+  return false;
+}
+
+static char *path_join(const char *dir, const char *name, const char *suffix) {
+  size_t len = strlen(dir) + 1 + strlen(name) + strlen(suffix) + 1;
+  char *path = malloc(len);
+  if (path) snprintf(path, len, "%s/%s%s", dir, name, suffix);
+  return path;
+}
+
+static bool batch_add(struct batch *batch, size_t *cap, const char *input, const char *outdir) {
+  if (batch->job_cnt == *cap) {
+    size_t newcap = *cap ? *cap * 2 : 64;
+    struct batch_job *jobs = realloc(batch->jobs, newcap * sizeof(*jobs));
+    if (!jobs) return false;
+    batch->jobs = jobs;
+    *cap = newcap;
+  }
+  const char *name = strrchr(input, '/');
+  name = name ? name + 1 : input;
+  struct batch_job *job = &batch->jobs[batch->job_cnt];
+  *job = (struct batch_job){0};
+  job->input = strdup(input);
+  job->output = path_join(outdir, name, ".wav");
+  if (batch->s98dir) job->s98output = path_join(batch->s98dir, name, ".s98");
+  if (!job->input || !job->output || (batch->s98dir && !job->s98output)) {
+    free((char *)job->input);
+    free(job->output);
+    free(job->s98output);
+    return false;
+  }
+  batch->job_cnt++;
+  return true;
+}
+
+static int batch_job_cmp(const void *a, const void *b) {
+  const struct batch_job *ja = a, *jb = b;
+  return strcmp(ja->input, jb->input);
+}
+
+// directories are expanded (not recursively) to the song files in them
+static bool batch_add_input(struct batch *batch, size_t *cap, const char *input, const char *outdir) {
+  struct stat st;
+  if (stat(input, &st) || !S_ISDIR(st.st_mode)) {
+    return batch_add(batch, cap, input, outdir);
+  }
+  DIR *dir = opendir(input);
+  if (!dir) {
+    perror(input);
+    return true;
+  }
+  const struct dirent *de;
+  bool ok = true;
+  size_t first = batch->job_cnt;
+  while (ok && (de = readdir(dir))) {
+    if (!is_song_file(de->d_name)) continue;
+    char *path = path_join(input, de->d_name, "");
+    ok = path && batch_add(batch, cap, path, outdir);
+    free(path);
+  }
+  closedir(dir);
+  qsort(batch->jobs + first, batch->job_cnt - first, sizeof(*batch->jobs), batch_job_cmp);
+  return ok;
+}
+
+static int batch_main(char **inputs, int input_cnt, const char *outdir,
+                      int loops, bool fade, double start_pos, int jobs,
+                      unsigned srate, const char *s98dir) {
+  struct batch batch = {
+    .loops = loops,
+    .fade = fade,
+    .start = start_pos,
+    .srate = srate,
+    .s98dir = s98dir,
+  };
+  size_t cap = 0;
+  for (int i = 0; i < input_cnt; i++) {
+    if (!batch_add_input(&batch, &cap, inputs[i], outdir)) {
+      perror("");
+      return 1;
+    }
   }
-  uint16_t bytes_per_block = CHANNELS * sizeof(int16_t);
-  w16le(buf, bytes_per_block);
-  if (fwrite(buf, 1, 2, file) < 2) {
-    perror(write_err);
+  if (!batch.job_cnt) {
+    fprintf(stderr, "no input files\n");
     return 1;
   }
-  uint16_t bits_per_sample = sizeof(int16_t) * 8;
-  w16le(buf, bits_per_sample);
-  if (fwrite(buf, 1, 2, file) < 2) {
-    perror(write_err);
-    return 1;
+  if (jobs <= 0) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    jobs = cpus > 0 ? cpus : 1;
   }
+  if ((size_t)jobs > batch.job_cnt) jobs = batch.job_cnt;
 
-  // Data chunk
-  if (fwrite("data", 1, 4, file) < 4) {
-    perror(write_err);
-    return 1;
-  }
-  w32le(buf, wav_bytes);
-  if (fwrite(buf, 1, 4, file) < 4) {
-    perror(write_err);
+  double start = monotonic_seconds();
+  pthread_t *threads = calloc(jobs, sizeof(*threads));
+  if (!threads) {
+    perror("");
     return 1;
   }
-  if (fwrite(wav_data, 1, wav_bytes, file) < wav_bytes) {
-    perror(write_err);
-    return 1;
+  int started = 0;
+  for (; started < jobs; started++) {
+    if (pthread_create(&threads[started], 0, batch_worker, &batch)) break;
   }
-
-  if (fclose(file) != 0) {
-    perror(write_err);
+  if (!started) {
+    fprintf(stderr, "cannot create worker threads\n");
     return 1;
   }
-  return 0;
+  for (int i = 0; i < started; i++) {
+    pthread_join(threads[i], 0);
+  }
+  free(threads);
+  double elapsed = monotonic_seconds() - start;
+
+  uint64_t total_frames = 0;
+  size_t failed = 0;
+  for (size_t i = 0; i < batch.job_cnt; i++) {
+    const struct batch_job *job = &batch.jobs[i];
+    if (job->ok) {
+      double length = (double)job->frames / srate;
+      printf("%s: %" PRIu64 ":%02" PRIu64 " in %.2fs (%.1fx realtime)\n",
+             job->input, (uint64_t)length / 60, (uint64_t)length % 60,
+             job->seconds, job->seconds > 0 ? length / job->seconds : 0.0);
+      total_frames += job->frames;
+    } else {
+      printf("%s: failed\n", job->input);
+      failed++;
+    }
+    free((char *)job->input);
+    free(job->output);
+    free(job->s98output);
+  }
+  free(batch.jobs);
+  double total_length = (double)total_frames / srate;
+  printf("%zu files (%zu failed), %d threads, %.1fs of audio in %.2fs (%.1fx realtime)\n",
+         batch.job_cnt, failed, started, total_length, elapsed,
+         elapsed > 0 ? total_length / elapsed : 0.0);
+  return failed ? 1 : 0;
 }
 
 int main(int argc, char **argv) {
   setlocale(LC_CTYPE, "");
+  opna_cpu_select();
 
   bool fade = true;
   int loops = 1;
   const char *output = 0;
+  int jobs = 0;
+  double start = 0;
+  unsigned srate = SRATE;
+  const char *s98output = 0;
+  long ppz8_cache_kib = PPZ8_CACHE_KIB;
 
   int optchar;
-  while ((optchar = getopt_long(argc, argv, "hFl:o:", options, 0)) != -1) {
+  while ((optchar = getopt_long(argc, argv, "hFl:o:j:s:r:S:c:", options, 0)) != -1) {
     switch (optchar) {
     case 'h':
       fprintf(stderr, usage, argv[0]);
@@ -482,20 +844,58 @@ int main(int argc, char **argv) {
     case 'o':
       output = optarg;
       break;
+    case 'j':
+      jobs = atoi(optarg);
+      break;
+    case 's':
+      start = atof(optarg);
+      break;
+    case 'r':
+      srate = atoi(optarg);
+      if (srate < OPNA_RATECVT_MIN_OUTRATE || srate > OPNA_RATECVT_MAX_OUTRATE) {
+        fprintf(stderr, "unsupported rate: %s\n", optarg);
+        return 1;
+      }
+      break;
+    case 'S':
+      s98output = optarg;
+      break;
+    case 'c':
+      ppz8_cache_kib = atol(optarg);
+      break;
     default:
       fprintf(stderr, usage, argv[0]);
       return 1;
     }
   }
-  if (optind + 1 != argc) {
+  if (optind >= argc) {
     fprintf(stderr, usage, argv[0]);
     return 1;
   }
+  if (s98output && start > 0) {
+    // the log always starts at the beginning of the song
+    fprintf(stderr, "--s98 cannot be used with --start\n");
+    return 1;
+  }
+  if (ppz8_cache_kib > 0) {
+    ppz8_cache_len = (size_t)ppz8_cache_kib * 1024 / sizeof(int16_t);
+  }
+  struct stat st;
+  if (optind + 1 != argc || (!stat(argv[optind], &st) && S_ISDIR(st.st_mode))) {
+    if (!output || !strcmp(output, "-")) {
+      fprintf(stderr, "batch mode needs an output directory (-o)\n");
+      return 1;
+    }
+    return batch_main(argv + optind, argc - optind, output, loops, fade, start, jobs, srate,
+                      s98output);
+  }
   char *filename = argv[optind];
+  // keep stdout clean for PCM output
+  FILE *info = (output && !strcmp(output, "-")) ? stderr : stdout;
 
   if (is_mml(filename)) {
     if (compile(&filename) != 0) return 1;
-    printf("Compiled output: %s\n\n", filename);
+    fprintf(info, "Compiled output: %s\n\n", filename);
   }
 
   enum fmplayer_file_error fmfile_error;
@@ -505,32 +905,47 @@ int main(int argc, char **argv) {
     return 1;
   }
 
-  struct opna opna = {0};
-  struct opna_timer timer = {0};
-  struct ppz8 ppz8 = {0};
-  struct fmdriver_work work = {0};
-  uint8_t adpcm_ram[OPNA_ADPCM_RAM_SIZE];
-  fmplayer_init_work_opna(&work, &ppz8, &opna, &timer, adpcm_ram);
-  opna_ssg_set_mix(&opna.ssg, 0x10000);
-  opna_ssg_set_ymf288(&opna.ssg, &opna.resampler, false);
-  ppz8_set_interpolation(&ppz8, PPZ8_INTERP_SINC);
-  opna_fm_set_hires_sin(&opna.fm, false);
-  opna_fm_set_hires_env(&opna.fm, false);
-  fmplayer_file_load(&work, fmfile, loops);
+  FILE *s98file = 0;
+  if (s98output) {
+    s98file = fopen(s98output, "wb");
+    if (!s98file) {
+      perror("cannot open S98 output file");
+      return 1;
+    }
+  }
+  struct render r = {0};
+  if (ppz8_cache_len) {
+    r.ppz8_cache_mem = malloc(ppz8_cache_len * sizeof(int16_t));
+    if (!r.ppz8_cache_mem) {
+      perror("cannot allocate PPZ8 cache");
+      return 1;
+    }
+  }
+  if (!render_init(&r, fmfile, loops, s98file)) {
+    perror("cannot write to S98 output file");
+    return 1;
+  }
+  if (!render_start(&r, start)) {
+    fprintf(stderr, "start position is past the end of the song\n");
+    return 1;
+  }
 
-  print_comments(&work);
+  print_comments(&r.work, info);
 
   struct mix_context ctx = {
-    .timer = &timer,
-    .work = &work,
+    .timer = &r.timer,
+    .ratecvt = mix_ratecvt(&r, srate),
+    .srate = srate,
+    .work = &r.work,
     .volume = VOLUME_INIT,
     .loops = loops,
     .fadeout_enabled = fade,
   };
 
-  if (output) {
-    return save(output, &ctx);
-  } else {
-    return play(&ctx);
+  int ret = output ? save(output, &ctx, 0) : play(&ctx);
+  if (s98file && !render_s98_close(&r, s98file)) {
+    perror("cannot write to S98 output file");
+    return 1;
   }
+  return ret;
 }
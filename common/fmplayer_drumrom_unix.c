@@ -2,12 +2,17 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
 #include "libopna/opnadrum.h"
 
 static struct {
   uint8_t drum_rom[OPNA_ROM_SIZE];
   bool loaded;
-} g;
+  // ROM is shared between threads (cli batch mode)
+  pthread_mutex_t lock;
+} g = {
+  .lock = PTHREAD_MUTEX_INITIALIZER,
+};
 
 #define DATADIR "/.local/share/98fmplayer/"
 
@@ -43,11 +48,15 @@ err:
 }
 
 bool fmplayer_drum_rom_load(struct opna_drum *drum) {
+  pthread_mutex_lock(&g.lock);
   if (!g.loaded) {
     loadfile();
   }
-  if (g.loaded) {
+  bool loaded = g.loaded;
+  pthread_mutex_unlock(&g.lock);
+  // read only after loaded
+  if (loaded) {
     opna_drum_set_rom(drum, g.drum_rom);
   }
-  return g.loaded;
+  return loaded;
 }
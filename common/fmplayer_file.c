@@ -1,6 +1,191 @@
 #include "common/fmplayer_file.h"
 #include <string.h>
 #include <stdlib.h>
+#include <stdatomic.h>
+
+enum {
+  LOOP_CACHE_SIZE = 64,
+  PCM_CACHE_SIZE = 8,
+};
+
+// loop lengths of recently loaded files, so that reloading or looping a
+// playlist does not replay the whole song again
+static struct {
+  atomic_flag flag;
+  unsigned next;
+  struct {
+    uint64_t hash;
+    uint32_t loop_timerb_cnt;
+    enum fmplayer_file_type type;
+    int loopcnt;
+    bool valid;
+  } entries[LOOP_CACHE_SIZE];
+} loop_cache = {
+  .flag = ATOMIC_FLAG_INIT,
+};
+
+uint64_t fmplayer_file_hash(uint64_t hash, const void *buf, size_t len) {
+  const uint8_t *p = buf;
+  for (size_t i = 0; i < len; i++) {
+    hash ^= p[i];
+    hash *= 0x100000001b3ull;
+  }
+  return hash;
+}
+
+static uint64_t file_hash(const void *buf, size_t len) {
+  return fmplayer_file_hash(FMPLAYER_FILE_HASH_INIT, buf, len);
+}
+
+static bool loop_cache_lookup(const struct fmplayer_file *fmfile, int loopcnt, uint32_t *loop_timerb_cnt) {
+  bool found = false;
+  while (atomic_flag_test_and_set_explicit(&loop_cache.flag, memory_order_acquire));
+  for (int i = 0; i < LOOP_CACHE_SIZE; i++) {
+    if (loop_cache.entries[i].valid &&
+        loop_cache.entries[i].hash == fmfile->hash &&
+        loop_cache.entries[i].type == fmfile->type &&
+        loop_cache.entries[i].loopcnt == loopcnt) {
+      *loop_timerb_cnt = loop_cache.entries[i].loop_timerb_cnt;
+      found = true;
+      break;
+    }
+  }
+  atomic_flag_clear_explicit(&loop_cache.flag, memory_order_release);
+  return found;
+}
+
+static void loop_cache_store(const struct fmplayer_file *fmfile, int loopcnt, uint32_t loop_timerb_cnt) {
+  while (atomic_flag_test_and_set_explicit(&loop_cache.flag, memory_order_acquire));
+  unsigned i = loop_cache.next;
+  loop_cache.next = (i + 1) % LOOP_CACHE_SIZE;
+  loop_cache.entries[i].hash = fmfile->hash;
+  loop_cache.entries[i].loop_timerb_cnt = loop_timerb_cnt;
+  loop_cache.entries[i].type = fmfile->type;
+  loop_cache.entries[i].loopcnt = loopcnt;
+  loop_cache.entries[i].valid = true;
+  atomic_flag_clear_explicit(&loop_cache.flag, memory_order_release);
+}
+
+// decoded PPZ8 banks, shared by files using the same bank file
+// (e.g. songs of an album)
+// the cache holds a reference to each bank in it, so the banks stay
+// decoded between songs until pushed out by newer ones
+struct fmplayer_pcm_bank {
+  // key
+  uint64_t hash;
+  size_t filelen;
+  bool pzi;
+  // fmplayer_filekey of the file last loaded as this bank,
+  // checked before mapping and hashing the file
+  uint64_t filekey;
+  bool filekey_valid;
+
+  // refcnt, lastuse and filekey are protected by pcm_cache.flag
+  unsigned refcnt;
+  uint64_t lastuse;
+  struct ppz8_pcmbuf pcmbuf;
+};
+
+static struct {
+  atomic_flag flag;
+  uint64_t clock;
+  struct fmplayer_pcm_bank *banks[PCM_CACHE_SIZE];
+} pcm_cache = {
+  .flag = ATOMIC_FLAG_INIT,
+};
+
+static bool pcm_bank_match(const struct fmplayer_pcm_bank *bank,
+                           uint64_t hash, size_t filelen, bool pzi) {
+  return bank->hash == hash && bank->filelen == filelen && bank->pzi == pzi;
+}
+
+static void pcm_bank_unref_locked(struct fmplayer_pcm_bank *bank) {
+  if (--bank->refcnt) return;
+  free(bank->pcmbuf.data);
+  free(bank);
+}
+
+static void pcm_bank_release(struct fmplayer_pcm_bank *bank) {
+  if (!bank) return;
+  while (atomic_flag_test_and_set_explicit(&pcm_cache.flag, memory_order_acquire));
+  pcm_bank_unref_locked(bank);
+  atomic_flag_clear_explicit(&pcm_cache.flag, memory_order_release);
+}
+
+static struct fmplayer_pcm_bank *pcm_cache_lookup_locked(uint64_t hash, size_t filelen, bool pzi) {
+  for (int i = 0; i < PCM_CACHE_SIZE; i++) {
+    struct fmplayer_pcm_bank *bank = pcm_cache.banks[i];
+    if (bank && pcm_bank_match(bank, hash, filelen, pzi)) {
+      bank->refcnt++;
+      bank->lastuse = ++pcm_cache.clock;
+      return bank;
+    }
+  }
+  return 0;
+}
+
+// filekey: remembered on the bank found if filekey_valid
+static struct fmplayer_pcm_bank *pcm_cache_lookup(uint64_t hash, size_t filelen, bool pzi,
+                                                  uint64_t filekey, bool filekey_valid) {
+  while (atomic_flag_test_and_set_explicit(&pcm_cache.flag, memory_order_acquire));
+  struct fmplayer_pcm_bank *bank = pcm_cache_lookup_locked(hash, filelen, pzi);
+  if (bank && filekey_valid) {
+    bank->filekey = filekey;
+    bank->filekey_valid = true;
+  }
+  atomic_flag_clear_explicit(&pcm_cache.flag, memory_order_release);
+  return bank;
+}
+
+static struct fmplayer_pcm_bank *pcm_cache_lookup_filekey(uint64_t filekey, size_t filelen, bool pzi) {
+  struct fmplayer_pcm_bank *found = 0;
+  while (atomic_flag_test_and_set_explicit(&pcm_cache.flag, memory_order_acquire));
+  for (int i = 0; i < PCM_CACHE_SIZE; i++) {
+    struct fmplayer_pcm_bank *bank = pcm_cache.banks[i];
+    if (bank && bank->filekey_valid && bank->filekey == filekey &&
+        bank->filelen == filelen && bank->pzi == pzi) {
+      bank->refcnt++;
+      bank->lastuse = ++pcm_cache.clock;
+      found = bank;
+      break;
+    }
+  }
+  atomic_flag_clear_explicit(&pcm_cache.flag, memory_order_release);
+  return found;
+}
+
+// returns the bank to use, which is a bank already in the cache if
+// another thread has decoded the same file in the meantime
+static struct fmplayer_pcm_bank *pcm_cache_store(struct fmplayer_pcm_bank *bank) {
+  while (atomic_flag_test_and_set_explicit(&pcm_cache.flag, memory_order_acquire));
+  struct fmplayer_pcm_bank *cached = pcm_cache_lookup_locked(bank->hash, bank->filelen, bank->pzi);
+  if (cached) {
+    pcm_bank_unref_locked(bank);
+    atomic_flag_clear_explicit(&pcm_cache.flag, memory_order_release);
+    return cached;
+  }
+  // empty slot, or else the least recently used bank not used by any file
+  int slot = -1;
+  for (int i = 0; i < PCM_CACHE_SIZE; i++) {
+    struct fmplayer_pcm_bank *b = pcm_cache.banks[i];
+    if (!b) {
+      slot = i;
+      break;
+    }
+    if (b->refcnt == 1 &&
+        (slot < 0 || b->lastuse < pcm_cache.banks[slot]->lastuse)) {
+      slot = i;
+    }
+  }
+  if (slot >= 0) {
+    if (pcm_cache.banks[slot]) pcm_bank_unref_locked(pcm_cache.banks[slot]);
+    pcm_cache.banks[slot] = bank;
+    bank->refcnt++;
+    bank->lastuse = ++pcm_cache.clock;
+  }
+  atomic_flag_clear_explicit(&pcm_cache.flag, memory_order_release);
+  return bank;
+}
 
 void fmplayer_file_free(const struct fmplayer_file *fmfileptr) {
   struct fmplayer_file *fmfile = (struct fmplayer_file *)fmfileptr;
@@ -8,8 +193,8 @@ void fmplayer_file_free(const struct fmplayer_file *fmfileptr) {
   free((void *)fmfile->filename_sjis);
   free(fmfile->path);
   free(fmfile->buf);
-  free(fmfile->ppzbuf[0]);
-  free(fmfile->ppzbuf[1]);
+  pcm_bank_release(fmfile->ppzbank[0]);
+  pcm_bank_release(fmfile->ppzbank[1]);
   free(fmfile);
 }
 
@@ -48,6 +233,7 @@ static void dummy_work_init(struct fmdriver_work *work, struct dummy_opna *dopna
   work->opna_readreg = opna_readreg_dummy;
   work->opna_status = opna_status_dummy;
   work->opna = dopna;
+  work->loop_analysis = true;
 }
 
 static struct driver_pmd *pmd_dup(const struct driver_pmd *pmd) {
@@ -120,6 +306,7 @@ struct fmplayer_file *fmplayer_file_alloc(const void *path, enum fmplayer_file_e
   size_t filesize;
   fmfile->buf = fmplayer_fileread(path, 0, 0, 0xffff, &filesize, error);
   if (!fmfile->buf) goto err;
+  fmfile->hash = file_hash(fmfile->buf, filesize);
   if (pmd_load(&fmfile->driver.pmd, fmfile->buf, filesize)) {
     fmfile->type = FMPLAYER_FILE_TYPE_PMD;
     return fmfile;
@@ -138,55 +325,77 @@ err:
 static void loadppc(struct fmdriver_work *work, struct fmplayer_file *fmfile) {
   if (!strlen(fmfile->driver.pmd.ppcfile)) return;
   size_t filesize;
-  void *ppcbuf = fmplayer_fileread(fmfile->path, fmfile->driver.pmd.ppcfile, ".PPC", 0, &filesize, 0);
+  const void *ppcbuf = fmplayer_filemap(fmfile->path, fmfile->driver.pmd.ppcfile, ".PPC", &filesize, 0);
   if (ppcbuf) {
     fmfile->pmd_ppc_err = !pmd_ppc_load(work, ppcbuf, filesize);
-    free(ppcbuf);
+    fmplayer_fileunmap(ppcbuf, filesize);
   } else {
     fmfile->pmd_ppc_err = true;
   }
 }
 
-static bool loadppzpvi(struct fmdriver_work *work, struct fmplayer_file *fmfile, int bnum, const char *name) {
+static bool loadppzbank(struct fmdriver_work *work, struct fmplayer_file *fmfile, int bnum, const char *name, bool pzi) {
   size_t filesize;
-  void *pvibuf = 0, *ppzbuf = 0;
-  pvibuf = fmplayer_fileread(fmfile->path, name, ".PVI", 0, &filesize, 0);
-  if (!pvibuf) goto err;
-  ppzbuf = calloc(ppz8_pvi_decodebuf_samples(filesize), 2);
-  if (!ppzbuf) goto err;
-  if (!ppz8_pvi_load(work->ppz8, bnum, pvibuf, filesize, ppzbuf)) goto err;
-  free(pvibuf);
-  free(fmfile->ppzbuf[bnum]);
-  fmfile->ppzbuf[bnum] = ppzbuf;
-  return true;
-err:
-  free(ppzbuf);
-  free(pvibuf);
-  return false;
-}
-
-static bool loadppzpzi(struct fmdriver_work *work, struct fmplayer_file *fmfile, int bnum, const char *name) {
-  size_t filesize;
-  void *pzibuf = 0, *ppzbuf = 0;
-  pzibuf = fmplayer_fileread(fmfile->path, name, ".PZI", 0, &filesize, 0);
-  if (!pzibuf) goto err;
-  ppzbuf = calloc(ppz8_pzi_decodebuf_samples(filesize), 2);
-  if (!ppzbuf) goto err;
-  if (!ppz8_pzi_load(work->ppz8, bnum, pzibuf, filesize, ppzbuf)) goto err;
-  free(pzibuf);
-  free(fmfile->ppzbuf[bnum]);
-  fmfile->ppzbuf[bnum] = ppzbuf;
+  struct fmplayer_pcm_bank *bank = 0;
+  int16_t *decodebuf = 0;
+  const char *extension = pzi ? ".PZI" : ".PVI";
+  // same file as a cached bank: no need to read it at all
+  uint64_t filekey = 0;
+  size_t keysize = 0;
+  bool filekey_valid = fmplayer_filekey(fmfile->path, name, extension, &filekey, &keysize);
+  if (filekey_valid) {
+    bank = pcm_cache_lookup_filekey(filekey, keysize, pzi);
+    if (bank) {
+      ppz8_set_pcmbuf(work->ppz8, bnum, &bank->pcmbuf);
+      pcm_bank_release(fmfile->ppzbank[bnum]);
+      fmfile->ppzbank[bnum] = bank;
+      return true;
+    }
+  }
+  const void *filebuf = fmplayer_filemap(fmfile->path, name, extension, &filesize, 0);
+  if (!filebuf) return false;
+  // the file may have changed between fmplayer_filekey and mapping it
+  if (filekey_valid && keysize != filesize) filekey_valid = false;
+  uint64_t hash = file_hash(filebuf, filesize);
+  bank = pcm_cache_lookup(hash, filesize, pzi, filekey, filekey_valid);
+  if (bank) {
+    ppz8_set_pcmbuf(work->ppz8, bnum, &bank->pcmbuf);
+  } else {
+    bank = calloc(1, sizeof(*bank));
+    if (!bank) goto err;
+    size_t samples = pzi ? ppz8_pzi_decodebuf_samples(filesize) : ppz8_pvi_decodebuf_samples(filesize);
+    decodebuf = calloc(samples, 2);
+    if (!decodebuf) goto err;
+    // decoded aside, so that a broken file leaves the current bank
+    // and the cache as they were
+    bool decoded = pzi
+      ? ppz8_pzi_decode(&bank->pcmbuf, filebuf, filesize, decodebuf)
+      : ppz8_pvi_decode(&bank->pcmbuf, filebuf, filesize, decodebuf);
+    if (!decoded) goto err;
+    bank->hash = hash;
+    bank->filelen = filesize;
+    bank->pzi = pzi;
+    bank->filekey = filekey;
+    bank->filekey_valid = filekey_valid;
+    bank->refcnt = 1;
+    bank = pcm_cache_store(bank);
+    ppz8_set_pcmbuf(work->ppz8, bnum, &bank->pcmbuf);
+  }
+  fmplayer_fileunmap(filebuf, filesize);
+  pcm_bank_release(fmfile->ppzbank[bnum]);
+  fmfile->ppzbank[bnum] = bank;
   return true;
 err:
-  free(ppzbuf);
-  free(pzibuf);
+  free(decodebuf);
+  free(bank);
+  fmplayer_fileunmap(filebuf, filesize);
   return false;
 }
 
 // returns true if error
 static bool loadpmdppz(struct fmdriver_work *work, struct fmplayer_file *fmfile,int bnum, const char *ppzfile) {
   if (!strlen(ppzfile)) false;
-  if (!loadppzpvi(work, fmfile, bnum, ppzfile) && !loadppzpzi(work, fmfile, bnum, ppzfile)) {
+  if (!loadppzbank(work, fmfile, bnum, ppzfile, false) && !loadppzbank(work, fmfile, bnum, ppzfile, true)) {
     return true;
   }
   return false;
@@ -196,10 +405,10 @@ static void loadpvi(struct fmdriver_work *work, struct fmplayer_file *fmfile) {
   const char *pvifile = fmfile->driver.fmp.pvi_name;
   if (!strlen(pvifile)) return;
   size_t filesize;
-  void *pvibuf = fmplayer_fileread(fmfile->path, pvifile, ".PVI", 0, &filesize, 0);
+  const void *pvibuf = fmplayer_filemap(fmfile->path, pvifile, ".PVI", &filesize, 0);
   if (pvibuf) {
     fmfile->fmp_pvi_err = !fmp_adpcm_load(work, pvibuf, filesize);
-    free(pvibuf);
+    fmplayer_fileunmap(pvibuf, filesize);
   } else {
     fmfile->fmp_pvi_err = true;
   }
@@ -208,7 +417,7 @@ static void loadpvi(struct fmdriver_work *work, struct fmplayer_file *fmfile) {
 static void loadfmpppz(struct fmdriver_work *work, struct fmplayer_file *fmfile) {
   const char *pvifile = fmfile->driver.fmp.ppz_name;
   if (!strlen(pvifile)) return;
-  fmfile->fmp_ppz_err = !loadppzpvi(work, fmfile, 0, pvifile);
+  fmfile->fmp_ppz_err = !loadppzbank(work, fmfile, 0, pvifile, false);
 }
 
 void fmplayer_file_load(struct fmdriver_work *work, struct fmplayer_file *fmfile, int loopcnt) {
@@ -216,7 +425,7 @@ void fmplayer_file_load(struct fmdriver_work *work, struct fmplayer_file *fmfile
   struct fmdriver_work dwork = {0};
   switch (fmfile->type) {
   case FMPLAYER_FILE_TYPE_PMD:
-    {
+    if (!loop_cache_lookup(fmfile, loopcnt, &work->loop_timerb_cnt)) {
       struct driver_pmd *pmddup = pmd_dup(&fmfile->driver.pmd);
       if (pmddup) {
         dummy_work_init(&dwork, &dopna);
@@ -224,6 +433,7 @@ void fmplayer_file_load(struct fmdriver_work *work, struct fmplayer_file *fmfile
         calc_loop(&dwork, loopcnt);
         pmd_free(pmddup);
         work->loop_timerb_cnt = dwork.loop_timerb_cnt;
+        loop_cache_store(fmfile, loopcnt, dwork.loop_timerb_cnt);
       }
     }
     pmd_init(work, &fmfile->driver.pmd);
@@ -233,7 +443,7 @@ void fmplayer_file_load(struct fmdriver_work *work, struct fmplayer_file *fmfile
     work->pcmerror[0] = fmfile->pmd_ppc_err;
     break;
   case FMPLAYER_FILE_TYPE_FMP:
-    {
+    if (!loop_cache_lookup(fmfile, loopcnt, &work->loop_timerb_cnt)) {
       struct driver_fmp *fmpdup = fmp_dup(&fmfile->driver.fmp);
       if (fmpdup) {
         dummy_work_init(&dwork, &dopna);
@@ -241,6 +451,7 @@ void fmplayer_file_load(struct fmdriver_work *work, struct fmplayer_file *fmfile
         calc_loop(&dwork, loopcnt);
         fmp_free(fmpdup);
         work->loop_timerb_cnt = dwork.loop_timerb_cnt;
+        loop_cache_store(fmfile, loopcnt, dwork.loop_timerb_cnt);
       }
     }
     fmp_init(work, &fmfile->driver.fmp);
@@ -22,6 +22,8 @@ enum fmplayer_file_error {
   FMPLAYER_FILE_ERR_COUNT
 };
 
+struct fmplayer_pcm_bank;
+
 struct fmplayer_file {
   void *path;
   enum fmplayer_file_type type;
@@ -33,7 +35,9 @@ struct fmplayer_file {
   bool fmp_pvi_err;
   bool fmp_ppz_err;
   void *buf;
-  void *ppzbuf[2];
+  // FNV-1a hash of the file contents, keys the loop length cache
+  uint64_t hash;
+  struct fmplayer_pcm_bank *ppzbank[2];
   // for display with FMDSP
   // might be NULL
   // currently only supports sjis (CP932)
@@ -53,6 +57,20 @@ const wchar_t *fmplayer_file_strerror_w(enum fmplayer_file_error error);
 //   fmplayer_fileread("/home/foo/bar.mz", "BAZ", ".PVI", &filesize);
 void *fmplayer_fileread(const void *path, const char *pcmname, const char *extension, size_t maxsize, size_t *filesize, enum fmplayer_file_error *error);
 
+// read-only view of a PCM file (pcmname is required), release with fmplayer_fileunmap
+// mmap()ed on unix, read into memory on other platforms
+const void *fmplayer_filemap(const void *path, const char *pcmname, const char *extension, size_t *filesize, enum fmplayer_file_error *error);
+void fmplayer_fileunmap(const void *buf, size_t filesize);
+
+// identity of a PCM file from its resolved path, size and modification time,
+// so that decoded banks can be found again without reading the file
+// returns false if not available on the platform, the contents are hashed then
+bool fmplayer_filekey(const void *path, const char *pcmname, const char *extension, uint64_t *key, size_t *filesize);
+
+#define FMPLAYER_FILE_HASH_INIT 0xcbf29ce484222325ull
+// FNV-1a, continuing from hash
+uint64_t fmplayer_file_hash(uint64_t hash, const void *buf, size_t len);
+
 // allocates string in sjis
 // free with free()
 char *fmplayer_path_filename_sjis(const void *path);
@@ -54,18 +54,12 @@ err:
   return 0;
 }
 
-void *fmplayer_fileread(const void *pathptr, const char *pcmname, const char *extension,
-                        size_t maxsize, size_t *filesize, enum fmplayer_file_error *error) {
-  GFile *file = 0, *dir = 0;
+// finds pcmname + extension case-insensitively in the directory of file
+static GFile *pcmfile_find(GFile *file, const char *pcmname, const char *extension,
+                           enum fmplayer_file_error *error) {
+  GFile *dir = 0;
   GFileEnumerator *direnum = 0;
   char *pcmnamebuf = 0;
-  const char *uri = pathptr;
-  file = g_file_new_for_uri(uri);
-  if (!pcmname) {
-    void *buf = fileread(file, maxsize, filesize, error);
-    g_object_unref(G_OBJECT(file));
-    return buf;
-  }
   if (extension) {
     size_t namebuflen = strlen(pcmname) + strlen(extension) + 1;
     pcmnamebuf = malloc(namebuflen);
@@ -97,14 +91,11 @@ void *fmplayer_fileread(const void *pathptr, const char *pcmname, const char *ex
     }
     GFile *pcmfile = g_file_enumerator_get_child(direnum, info);
     if (!strcasecmp(g_file_info_get_name(info), pcmname)) {
-      void *buf = fileread(pcmfile, maxsize, filesize, error);
-      g_object_unref(G_OBJECT(pcmfile));
       g_object_unref(G_OBJECT(info));
       g_object_unref(G_OBJECT(direnum));
       g_object_unref(G_OBJECT(dir));
-      g_object_unref(G_OBJECT(file));
       free(pcmnamebuf);
-      return buf;
+      return pcmfile;
     }
     g_object_unref(G_OBJECT(pcmfile));
     g_object_unref(G_OBJECT(info));
@@ -113,11 +104,76 @@ void *fmplayer_fileread(const void *pathptr, const char *pcmname, const char *ex
 err:
   if (direnum) g_object_unref(G_OBJECT(direnum));
   if (dir) g_object_unref(G_OBJECT(dir));
-  g_object_unref(G_OBJECT(file));
   free(pcmnamebuf);
   return 0;
 }
 
+void *fmplayer_fileread(const void *pathptr, const char *pcmname, const char *extension,
+                        size_t maxsize, size_t *filesize, enum fmplayer_file_error *error) {
+  const char *uri = pathptr;
+  GFile *file = g_file_new_for_uri(uri);
+  void *buf = 0;
+  if (!pcmname) {
+    buf = fileread(file, maxsize, filesize, error);
+  } else {
+    GFile *pcmfile = pcmfile_find(file, pcmname, extension, error);
+    if (pcmfile) {
+      buf = fileread(pcmfile, maxsize, filesize, error);
+      g_object_unref(G_OBJECT(pcmfile));
+    }
+  }
+  g_object_unref(G_OBJECT(file));
+  return buf;
+}
+
+bool fmplayer_filekey(const void *pathptr, const char *pcmname, const char *extension,
+                      uint64_t *key, size_t *filesize) {
+  const char *uri = pathptr;
+  GFile *file = g_file_new_for_uri(uri);
+  GFile *pcmfile = pcmfile_find(file, pcmname, extension, 0);
+  GFileInfo *finfo = 0;
+  char *pcmuri = 0;
+  bool ret = false;
+  if (!pcmfile) goto err;
+  finfo = g_file_query_info(pcmfile,
+                            G_FILE_ATTRIBUTE_STANDARD_SIZE ","
+                            G_FILE_ATTRIBUTE_TIME_MODIFIED ","
+                            G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC,
+                            G_FILE_QUERY_INFO_NONE, 0, 0);
+  if (!finfo) goto err;
+  // not every backend (e.g. remote ones) reports a modification time
+  if (!g_file_info_has_attribute(finfo, G_FILE_ATTRIBUTE_TIME_MODIFIED)) goto err;
+  goffset size = g_file_info_get_size(finfo);
+  if (size <= 0) goto err;
+  pcmuri = g_file_get_uri(pcmfile);
+  if (!pcmuri) goto err;
+  uint64_t stamp[3] = {
+    size,
+    g_file_info_get_attribute_uint64(finfo, G_FILE_ATTRIBUTE_TIME_MODIFIED),
+    g_file_info_get_attribute_uint32(finfo, G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC),
+  };
+  uint64_t hash = fmplayer_file_hash(FMPLAYER_FILE_HASH_INIT, pcmuri, strlen(pcmuri));
+  *key = fmplayer_file_hash(hash, stamp, sizeof(stamp));
+  *filesize = size;
+  ret = true;
+err:
+  g_free(pcmuri);
+  if (finfo) g_object_unref(G_OBJECT(finfo));
+  if (pcmfile) g_object_unref(G_OBJECT(pcmfile));
+  g_object_unref(G_OBJECT(file));
+  return ret;
+}
+
+const void *fmplayer_filemap(const void *path, const char *pcmname, const char *extension,
+                             size_t *filesize, enum fmplayer_file_error *error) {
+  return fmplayer_fileread(path, pcmname, extension, 0, filesize, error);
+}
+
+void fmplayer_fileunmap(const void *buf, size_t filesize) {
+  (void)filesize;
+  free((void *)buf);
+}
+
 void *fmplayer_path_dup(const void *path) {
   return strdup(path);
 }
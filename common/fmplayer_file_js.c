@@ -83,6 +83,27 @@ err:
   return 0;
 }
 
+const void *fmplayer_filemap(const void *path, const char *pcmname, const char *extension,
+                             size_t *filesize, enum fmplayer_file_error *error) {
+  return fmplayer_fileread(path, pcmname, extension, 0, filesize, error);
+}
+
+bool fmplayer_filekey(const void *path, const char *pcmname, const char *extension,
+                      uint64_t *key, size_t *filesize) {
+  // files are handed over from the page without a modification time
+  (void)path;
+  (void)pcmname;
+  (void)extension;
+  (void)key;
+  (void)filesize;
+  return false;
+}
+
+void fmplayer_fileunmap(const void *buf, size_t filesize) {
+  (void)filesize;
+  free((void *)buf);
+}
+
 char *fmplayer_path_filename_sjis(const void *path) {
   // TODO: Shift JIS conversion
   return strdup(path);
@@ -1,9 +1,16 @@
 #include "common/fmplayer_file.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
 #include <dirent.h>
 #include <string.h>
 #include <strings.h>
+// WASI (used by the headless benchmark) has neither mmap nor iconv
+#ifndef __wasi__
+#include <sys/mman.h>
 #include <iconv.h>
 #ifdef __APPLE__
 #include <xlocale.h>
@@ -11,6 +18,7 @@
 #include <locale.h>
 #endif
 #include <langinfo.h>
+#endif
 
 static void *fileread(const char *path, size_t maxsize, size_t *filesize, enum fmplayer_file_error *error) {
   FILE *f = 0;
@@ -60,11 +68,10 @@ err:
   return 0;
 }
 
-void *fmplayer_fileread(const void *pathptr, const char *pcmname, const char *extension,
-                        size_t maxsize, size_t *filesize, enum fmplayer_file_error *error) {
-  const char *path = pathptr;
-  if (!pcmname) return fileread(path, maxsize, filesize, error);
-
+// finds pcmname + extension case-insensitively in the directory of path
+// returns malloc()ed path
+static char *pcmpath_find(const char *path, const char *pcmname, const char *extension,
+                          enum fmplayer_file_error *error) {
   char *namebuf = 0;
   char *dirbuf = 0;
   DIR *d = 0;
@@ -96,7 +103,7 @@ void *fmplayer_fileread(const void *pathptr, const char *pcmname, const char *ex
   }
   d = opendir(dirpath);
   if (!d) {
-    *error = FMPLAYER_FILE_ERR_FILEIO;
+    if (error) *error = FMPLAYER_FILE_ERR_FILEIO;
     goto err;
   }
   const struct dirent *de;
@@ -111,12 +118,10 @@ void *fmplayer_fileread(const void *pathptr, const char *pcmname, const char *ex
       strcpy(pcmpath, dirpath);
       strcat(pcmpath, "/");
       strcat(pcmpath, de->d_name);
-      void *buf = fileread(pcmpath, maxsize, filesize, error);
-      free(pcmpath);
       closedir(d);
       free(dirbuf);
       free(namebuf);
-      return buf;
+      return pcmpath;
     }
   }
   if (error) *error = FMPLAYER_FILE_ERR_NOTFOUND;
@@ -127,12 +132,102 @@ err:
   return 0;
 }
 
+void *fmplayer_fileread(const void *pathptr, const char *pcmname, const char *extension,
+                        size_t maxsize, size_t *filesize, enum fmplayer_file_error *error) {
+  const char *path = pathptr;
+  if (!pcmname) return fileread(path, maxsize, filesize, error);
+  char *pcmpath = pcmpath_find(path, pcmname, extension, error);
+  if (!pcmpath) return 0;
+  void *buf = fileread(pcmpath, maxsize, filesize, error);
+  free(pcmpath);
+  return buf;
+}
+
+static const void *filemap(const char *path, size_t *filesize, enum fmplayer_file_error *error) {
+#ifdef __wasi__
+  return fileread(path, 0, filesize, error);
+#else
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    if (error) *error = FMPLAYER_FILE_ERR_NOTFOUND;
+    return 0;
+  }
+  struct stat st;
+  if (fstat(fd, &st)) {
+    if (error) *error = FMPLAYER_FILE_ERR_FILEIO;
+    goto err;
+  }
+  // mmap cannot map empty files
+  if (!st.st_size || (uintmax_t)st.st_size > SIZE_MAX) {
+    if (error) *error = FMPLAYER_FILE_ERR_BADFILE_SIZE;
+    goto err;
+  }
+  void *buf = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (buf == MAP_FAILED) {
+    if (error) *error = FMPLAYER_FILE_ERR_FILEIO;
+    goto err;
+  }
+  // the mapping stays valid after close
+  close(fd);
+  *filesize = st.st_size;
+  return buf;
+err:
+  close(fd);
+  return 0;
+#endif
+}
+
+const void *fmplayer_filemap(const void *pathptr, const char *pcmname, const char *extension,
+                             size_t *filesize, enum fmplayer_file_error *error) {
+  char *pcmpath = pcmpath_find(pathptr, pcmname, extension, error);
+  if (!pcmpath) return 0;
+  const void *buf = filemap(pcmpath, filesize, error);
+  free(pcmpath);
+  return buf;
+}
+
+bool fmplayer_filekey(const void *pathptr, const char *pcmname, const char *extension,
+                      uint64_t *key, size_t *filesize) {
+  char *pcmpath = pcmpath_find(pathptr, pcmname, extension, 0);
+  if (!pcmpath) return false;
+  struct stat st;
+  int err = stat(pcmpath, &st);
+  free(pcmpath);
+  if (err || !st.st_size || (uintmax_t)st.st_size > SIZE_MAX) return false;
+#ifdef __APPLE__
+  const struct timespec *mtime = &st.st_mtimespec;
+#else
+  const struct timespec *mtime = &st.st_mtim;
+#endif
+  // device and inode identify the file the path resolves to,
+  // whichever directory or symlink it was reached through
+  uint64_t stamp[5] = {
+    st.st_dev, st.st_ino, st.st_size, mtime->tv_sec, mtime->tv_nsec,
+  };
+  *key = fmplayer_file_hash(FMPLAYER_FILE_HASH_INIT, stamp, sizeof(stamp));
+  *filesize = st.st_size;
+  return true;
+}
+
+void fmplayer_fileunmap(const void *buf, size_t filesize) {
+#ifdef __wasi__
+  (void)filesize;
+  free((void *)buf);
+#else
+  if (buf) munmap((void *)buf, filesize);
+#endif
+}
+
 void *fmplayer_path_dup(const void *path) {
   return strdup(path);
 }
 
 char *fmplayer_path_filename_sjis(const void *pathptr) {
   char *path = (char *)pathptr;
+#ifdef __wasi__
+  const char *fname = strrchr(path, '/');
+  return strdup(fname ? fname + 1 : path);
+#else
   locale_t loc = 0;
   iconv_t ic = (iconv_t)-1;
   char *pathbuf = 0;
@@ -172,4 +267,5 @@ err:
   if (ic != (iconv_t)-1) iconv_close(ic);
   if (loc) freelocale(loc);
   return strdup(fname);
+#endif
 }
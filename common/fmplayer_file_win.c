@@ -60,16 +60,10 @@ err:
   return 0;
 }
 
-void *fmplayer_fileread(const void *pathptr, const char *pcmname, const char *extension,
-                        size_t maxsize, size_t *filesize, enum fmplayer_file_error *error) {
-  const wchar_t *path = 0;
-#if defined(FMPLAYER_FILE_WIN_UTF16)
-  path = wcsdup(pathptr);
-#elif defined(FMPLAYER_FILE_WIN_UTF8)
-  path = u8tou16(pathptr);
-#endif
+// pcmname + extension in the directory of path
+// returns malloc()ed path
+static wchar_t *pcmpath_build(const wchar_t *path, const char *pcmname, const char *extension) {
   wchar_t *wpcmpath = 0, *wpcmname = 0, *wpcmextname = 0;
-  if (!pcmname) return fileread(path, maxsize, filesize, error);
   int wpcmnamelen = MultiByteToWideChar(932, 0, pcmname, -1, 0, 0);
   if (!wpcmnamelen) goto err;
   if (extension) {
@@ -91,20 +85,86 @@ void *fmplayer_fileread(const void *pathptr, const char *pcmname, const char *ex
   PathRemoveFileSpecW(wpcmpath);
   wcscat(wpcmpath, L"\\");
   wcscat(wpcmpath, wpcmname);
-  void *buf = fileread(wpcmpath, maxsize, filesize, error);
   free(wpcmextname);
   free(wpcmname);
-  free(wpcmpath);
-  free((void *)path);
-  return buf;
+  return wpcmpath;
 err:
   free(wpcmextname);
   free(wpcmname);
   free(wpcmpath);
-  free((void *)path);
   return 0;
 }
 
+static wchar_t *path_u16(const void *pathptr) {
+#if defined(FMPLAYER_FILE_WIN_UTF16)
+  return wcsdup(pathptr);
+#elif defined(FMPLAYER_FILE_WIN_UTF8)
+  return u8tou16(pathptr);
+#endif
+}
+
+void *fmplayer_fileread(const void *pathptr, const char *pcmname, const char *extension,
+                        size_t maxsize, size_t *filesize, enum fmplayer_file_error *error) {
+  wchar_t *path = path_u16(pathptr);
+  if (!path) {
+    if (error) *error = FMPLAYER_FILE_ERR_NOMEM;
+    return 0;
+  }
+  void *buf = 0;
+  if (!pcmname) {
+    buf = fileread(path, maxsize, filesize, error);
+  } else {
+    wchar_t *wpcmpath = pcmpath_build(path, pcmname, extension);
+    if (wpcmpath) buf = fileread(wpcmpath, maxsize, filesize, error);
+    free(wpcmpath);
+  }
+  free(path);
+  return buf;
+}
+
+bool fmplayer_filekey(const void *pathptr, const char *pcmname, const char *extension,
+                      uint64_t *key, size_t *filesize) {
+  wchar_t *path = 0, *wpcmpath = 0, *fullpath = 0;
+  bool ret = false;
+  path = path_u16(pathptr);
+  if (!path) goto err;
+  wpcmpath = pcmpath_build(path, pcmname, extension);
+  if (!wpcmpath) goto err;
+  DWORD fullpathlen = GetFullPathNameW(wpcmpath, 0, 0, 0);
+  if (!fullpathlen) goto err;
+  fullpath = malloc(fullpathlen * sizeof(wchar_t));
+  if (!fullpath) goto err;
+  if (!GetFullPathNameW(wpcmpath, fullpathlen, fullpath, 0)) goto err;
+  // names are case-insensitive, as when opening the file
+  CharUpperW(fullpath);
+  WIN32_FILE_ATTRIBUTE_DATA attr;
+  if (!GetFileAttributesExW(fullpath, GetFileExInfoStandard, &attr)) goto err;
+  if (attr.nFileSizeHigh || !attr.nFileSizeLow) goto err;
+  uint64_t stamp[2] = {
+    attr.nFileSizeLow,
+    ((uint64_t)attr.ftLastWriteTime.dwHighDateTime << 32) | attr.ftLastWriteTime.dwLowDateTime,
+  };
+  uint64_t hash = fmplayer_file_hash(FMPLAYER_FILE_HASH_INIT, fullpath, wcslen(fullpath) * sizeof(wchar_t));
+  *key = fmplayer_file_hash(hash, stamp, sizeof(stamp));
+  *filesize = attr.nFileSizeLow;
+  ret = true;
+err:
+  free(fullpath);
+  free(wpcmpath);
+  free(path);
+  return ret;
+}
+
+const void *fmplayer_filemap(const void *path, const char *pcmname, const char *extension,
+                             size_t *filesize, enum fmplayer_file_error *error) {
+  return fmplayer_fileread(path, pcmname, extension, 0, filesize, error);
+}
+
+void fmplayer_fileunmap(const void *buf, size_t filesize) {
+  (void)filesize;
+  free((void *)buf);
+}
+
 void *fmplayer_path_dup(const void *pathptr) {
 #if defined(FMPLAYER_FILE_WIN_UTF16)
   const wchar_t *path = pathptr;
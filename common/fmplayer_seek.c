@@ -0,0 +1,198 @@
+#include "common/fmplayer_seek.h"
+#include "common/fmplayer_file.h"
+#include "libopna/opna.h"
+#include "libopna/opnatimer.h"
+#include "fmdriver/ppz8.h"
+#include "leveldata/leveldata.h"
+#include <stdlib.h>
+#include <string.h>
+
+enum {
+  // frames skipped between checkpoint checks while fast-forwarding
+  SEEK_SKIP_FRAMES = 256,
+};
+
+struct fmplayer_seek_checkpoint {
+  uint64_t frames;
+  struct fmdriver_work work;
+  union {
+    struct driver_pmd pmd;
+    struct driver_fmp fmp;
+  } driver;
+  struct opna opna;
+  struct opna_timer timer;
+  struct ppz8 ppz8;
+  // PMD rewrites repeat counters in its data
+  size_t datalen;
+  uint8_t data[];
+};
+
+static uint8_t *driver_data(const struct fmplayer_seek *seek, size_t *datalen) {
+  if (seek->fmfile->type == FMPLAYER_FILE_TYPE_PMD) {
+    const struct driver_pmd *pmd = seek->work->driver;
+    *datalen = pmd->datalen + 1;
+    return pmd->data - 1;
+  }
+  *datalen = 0;
+  return 0;
+}
+
+static size_t driver_size(const struct fmplayer_seek *seek) {
+  return seek->fmfile->type == FMPLAYER_FILE_TYPE_PMD ?
+    sizeof(struct driver_pmd) : sizeof(struct driver_fmp);
+}
+
+static bool checkpoint_store(struct fmplayer_seek *seek) {
+  if (seek->checkpoint_cnt == seek->checkpoint_cap) {
+    size_t newcap = seek->checkpoint_cap ? seek->checkpoint_cap * 2 : 16;
+    struct fmplayer_seek_checkpoint **checkpoints =
+      realloc(seek->checkpoints, newcap * sizeof(*checkpoints));
+    if (!checkpoints) return false;
+    seek->checkpoints = checkpoints;
+    seek->checkpoint_cap = newcap;
+  }
+  size_t datalen;
+  const uint8_t *data = driver_data(seek, &datalen);
+  struct fmplayer_seek_checkpoint *cp = malloc(sizeof(*cp) + datalen);
+  if (!cp) return false;
+  cp->frames = seek->opna->generated_frames;
+  cp->work = *seek->work;
+  memcpy(&cp->driver, seek->work->driver, driver_size(seek));
+  cp->opna = *seek->opna;
+  cp->timer = *seek->timer;
+  cp->ppz8 = *seek->ppz8;
+  cp->datalen = datalen;
+  if (datalen) memcpy(cp->data, data, datalen);
+  seek->checkpoints[seek->checkpoint_cnt++] = cp;
+  return true;
+}
+
+static void leveldata_reset(struct opna *opna, struct ppz8 *ppz8) {
+#ifdef LIBOPNA_ENABLE_LEVELDATA
+  for (int c = 0; c < 6; c++) {
+    leveldata_init(&opna->fm.channel[c].leveldata);
+    leveldata_init(&opna->drum.drums[c].leveldata);
+  }
+  for (int c = 0; c < 3; c++) {
+    leveldata_init(&opna->resampler.leveldata[c]);
+  }
+  leveldata_init(&opna->adpcm.leveldata);
+#else
+  (void)opna;
+#endif
+  for (int c = 0; c < 8; c++) {
+    leveldata_init(&ppz8->channel[c].leveldata);
+  }
+}
+
+// user settings are kept, only the playback state is restored
+static void checkpoint_restore(struct fmplayer_seek *seek,
+                               const struct fmplayer_seek_checkpoint *cp) {
+  struct opna *opna = seek->opna;
+  struct ppz8 *ppz8 = seek->ppz8;
+  unsigned opna_mask = opna_get_mask(opna);
+  bool hires_sin = opna->fm.hires_sin;
+  bool hires_env = opna->fm.hires_env;
+  bool soa = opna->fm.soa;
+  bool ymf288 = opna->ssg.ymf288;
+  uint32_t ssg_mix = opna->ssg.mix;
+  unsigned ppz8_mask = ppz8_get_mask(ppz8);
+  enum ppz8_interp interp = ppz8->interp;
+  struct ppz8_cache *ppz8_cache = ppz8->cache;
+  bool paused = seek->work->paused;
+
+  *opna = cp->opna;
+  *seek->timer = cp->timer;
+  *ppz8 = cp->ppz8;
+  *seek->work = cp->work;
+  memcpy(seek->work->driver, &cp->driver, driver_size(seek));
+  size_t datalen;
+  uint8_t *data = driver_data(seek, &datalen);
+  if (datalen) memcpy(data, cp->data, datalen);
+
+  opna_set_mask(opna, opna_mask);
+  opna_fm_set_hires_sin(&opna->fm, hires_sin);
+  opna_fm_set_hires_env(&opna->fm, hires_env);
+  opna_fm_set_soa(&opna->fm, soa);
+  opna_ssg_set_ymf288(&opna->ssg, &opna->resampler, ymf288);
+  opna_ssg_set_mix(&opna->ssg, ssg_mix);
+  ppz8_set_mask(ppz8, ppz8_mask);
+  ppz8_set_interpolation(ppz8, interp);
+  // the cache is keyed by PCM data and pitch, no need to flush it
+  ppz8->cache = ppz8_cache;
+  seek->work->paused = paused;
+  leveldata_reset(opna, ppz8);
+}
+
+bool fmplayer_seek_init(struct fmplayer_seek *seek,
+                        struct fmdriver_work *work,
+                        struct fmplayer_file *fmfile,
+                        struct opna_timer *timer,
+                        struct ppz8 *ppz8,
+                        uint32_t interval) {
+  *seek = (struct fmplayer_seek) {
+    .work = work,
+    .fmfile = fmfile,
+    .opna = timer->opna,
+    .timer = timer,
+    .ppz8 = ppz8,
+    .interval = interval ? interval : FMPLAYER_SEEK_INTERVAL,
+  };
+  if (!checkpoint_store(seek)) {
+    fmplayer_seek_deinit(seek);
+    return false;
+  }
+  return true;
+}
+
+void fmplayer_seek_deinit(struct fmplayer_seek *seek) {
+  for (size_t i = 0; i < seek->checkpoint_cnt; i++) {
+    free(seek->checkpoints[i]);
+  }
+  free(seek->checkpoints);
+  seek->checkpoints = 0;
+  seek->checkpoint_cnt = 0;
+  seek->checkpoint_cap = 0;
+}
+
+void fmplayer_seek_record(struct fmplayer_seek *seek) {
+  if (!seek->checkpoint_cnt) return;
+  uint64_t next = (uint64_t)seek->checkpoint_cnt * seek->interval;
+  if (seek->work->timerb_cnt < next) return;
+  // on allocation failure seeking still works from the earlier checkpoints
+  checkpoint_store(seek);
+}
+
+bool fmplayer_seek(struct fmplayer_seek *seek, uint64_t frame) {
+  if (!seek->checkpoint_cnt) return false;
+  // last checkpoint at or before frame
+  size_t lo = 0, hi = seek->checkpoint_cnt;
+  while (hi - lo > 1) {
+    size_t mid = (lo + hi) / 2;
+    if (seek->checkpoints[mid]->frames <= frame) lo = mid;
+    else hi = mid;
+  }
+  const struct fmplayer_seek_checkpoint *cp = seek->checkpoints[lo];
+  uint64_t current = seek->opna->generated_frames;
+  // no need to go back if the current position is closer
+  if (current > frame || current < cp->frames) {
+    checkpoint_restore(seek, cp);
+  }
+  while (seek->opna->generated_frames < frame) {
+    if (!seek->work->playing) return false;
+    uint64_t left = frame - seek->opna->generated_frames;
+    opna_timer_skip(seek->timer, left < SEEK_SKIP_FRAMES ? left : SEEK_SKIP_FRAMES);
+    fmplayer_seek_record(seek);
+  }
+  return true;
+}
+
+bool fmplayer_skip(struct fmdriver_work *work, struct opna_timer *timer,
+                   uint64_t frame) {
+  while (timer->opna->generated_frames < frame) {
+    if (!work->playing) return false;
+    uint64_t left = frame - timer->opna->generated_frames;
+    opna_timer_skip(timer, left < SEEK_SKIP_FRAMES ? left : SEEK_SKIP_FRAMES);
+  }
+  return true;
+}
@@ -0,0 +1,62 @@
+#ifndef MYON_FMPLAYER_SEEK_H_INCLUDED
+#define MYON_FMPLAYER_SEEK_H_INCLUDED
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+enum {
+  // default checkpoint interval, in timer B ticks
+  FMPLAYER_SEEK_INTERVAL = 256,
+};
+
+struct fmdriver_work;
+struct fmplayer_file;
+struct opna;
+struct opna_timer;
+struct ppz8;
+struct fmplayer_seek_checkpoint;
+
+// seeking for a loaded file:
+// snapshots of the driver, opna, timer and ppz8 are recorded every
+// interval timer B ticks, and seeking restores the nearest checkpoint
+// before the target and fast-forwards with opna_timer_skip from there.
+// after a fast-forward, notes keyed on during the skip start from the
+// beginning of their envelope instead of where they would be.
+struct fmplayer_seek {
+  struct fmdriver_work *work;
+  struct fmplayer_file *fmfile;
+  struct opna *opna;
+  struct opna_timer *timer;
+  struct ppz8 *ppz8;
+  uint32_t interval;
+  struct fmplayer_seek_checkpoint **checkpoints;
+  size_t checkpoint_cnt;
+  size_t checkpoint_cap;
+};
+
+// call right after fmplayer_file_load, before mixing
+// records the first checkpoint, returns false on allocation failure
+bool fmplayer_seek_init(struct fmplayer_seek *seek,
+                        struct fmdriver_work *work,
+                        struct fmplayer_file *fmfile,
+                        struct opna_timer *timer,
+                        struct ppz8 *ppz8,
+                        uint32_t interval);
+void fmplayer_seek_deinit(struct fmplayer_seek *seek);
+
+// call between mixes during playback
+// records a checkpoint when the next interval boundary has been passed
+void fmplayer_seek_record(struct fmplayer_seek *seek);
+
+// seek to frame (counted in opna->generated_frames)
+// returns false if the song ended before frame
+bool fmplayer_seek(struct fmplayer_seek *seek, uint64_t frame);
+
+// fast-forward from the current position to frame without recording
+// checkpoints, for frontends that only seek once before playback
+// returns false if the song ended before frame
+bool fmplayer_skip(struct fmdriver_work *work, struct opna_timer *timer,
+                   uint64_t frame);
+
+#endif // MYON_FMPLAYER_SEEK_H_INCLUDED
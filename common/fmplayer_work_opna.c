@@ -40,6 +40,11 @@ static void opna_mix_cb(void *userptr, int16_t *buf, unsigned samples) {
   ppz8_mix(ppz8, buf, samples);
 }
 
+static void opna_mix32_cb(void *userptr, int32_t *buf, unsigned samples) {
+  struct ppz8 *ppz8 = (struct ppz8 *)userptr;
+  ppz8_mix32(ppz8, buf, samples);
+}
+
 void fmplayer_init_work_opna(
   struct fmdriver_work *work,
   struct ppz8 *ppz8,
@@ -48,6 +53,8 @@ void fmplayer_init_work_opna(
   void *adpcm_ram
 ) {
   opna_reset(opna);
+  // the SoA FM engine only pays off with the AVX2 kernel
+  opna_fm_set_soa(&opna->fm, opna_fm_soa_preferred);
   fmplayer_drum_rom_load(&opna->drum);
   opna_adpcm_set_ram_256k(&opna->adpcm, adpcm_ram);
   opna_timer_reset(timer, opna);
@@ -61,4 +68,5 @@ void fmplayer_init_work_opna(
   work->ppz8_functbl = &ppz8_functbl;
   opna_timer_set_int_callback(timer, opna_int_cb, work);
   opna_timer_set_mix_callback(timer, opna_mix_cb, ppz8);
+  opna_timer_set_mix32_callback(timer, opna_mix32_cb, ppz8);
 }
@@ -3,24 +3,40 @@
 #include <string.h>
 
 void fft_write(struct fmplayer_fft_data *data, const int16_t *buf, unsigned len) {
-  if (len > FFTLEN) {
-    unsigned discard = len - FFTLEN;
+  if (len > FFTBUFLEN) {
+    unsigned discard = len - FFTBUFLEN;
     buf += discard*2;
-    len = FFTLEN;
+    len = FFTBUFLEN;
   }
-  unsigned towrite = FFTLEN - data->ind;
+  unsigned towrite = FFTBUFLEN - data->ind;
   if (towrite > len) towrite = len;
   for (unsigned i = 0; i < towrite; i++) {
     data->buf[data->ind+i] = ((uint32_t)buf[2*i+0] + buf[2*i+1]) / 2;
   }
-  data->ind = (data->ind + towrite) % FFTLEN;
+  data->ind = (data->ind + towrite) % FFTBUFLEN;
   buf += towrite*2;
   len -= towrite;
 
   for (unsigned i = 0; i < len; i++) {
     data->buf[i] = ((uint32_t)buf[2*i+0] + buf[2*i+1]) / 2;
   }
-  data->ind = (data->ind + len) % FFTLEN;
+  data->ind = (data->ind + len) % FFTBUFLEN;
+}
+
+void fft_write_f32(struct fmplayer_fft_data *data, const float *l, const float *r, unsigned len) {
+  if (len > FFTBUFLEN) {
+    unsigned discard = len - FFTBUFLEN;
+    l += discard;
+    r += discard;
+    len = FFTBUFLEN;
+  }
+  for (unsigned i = 0; i < len; i++) {
+    // same as fft_write with the int16 output
+    int16_t ls = l[i] * 32768;
+    int16_t rs = r[i] * 32768;
+    data->buf[(data->ind+i) % FFTBUFLEN] = ((uint32_t)ls + rs) / 2;
+  }
+  data->ind = (data->ind + len) % FFTBUFLEN;
 }
 
 static const uint16_t fftfreqtab[FFTDISPLEN+1] = {
@@ -121,8 +137,11 @@ static void fft_real(float *fftbuf) {
 }
 
 void fft_calc(struct fmplayer_fft_disp_data *ddata, struct fmplayer_fft_input_data *idata) {
+  unsigned delay = idata->delay < FFTDELAYMAX ? idata->delay : FFTDELAYMAX;
+  // oldest sample of the window, the window ends delay samples before ind
+  unsigned start = idata->fdata.ind + FFTDELAYMAX - delay;
   for (int i = 0; i < FFTLEN; i++) {
-    int fi = (i + idata->fdata.ind) % FFTLEN;
+    int fi = (start + i) % FFTBUFLEN;
     idata->work[i] = (((int32_t)idata->fdata.buf[fi]) * window[i]) >> 16;
   }
   for (int i = 0; i < FFTLEN; i++) {
@@ -137,13 +156,17 @@ void fft_calc(struct fmplayer_fft_disp_data *ddata, struct fmplayer_fft_input_da
   for (int i = 0; i < FFTLEN/2; i++) {
     idata->fwork[i] = idata->fwork[i] / sqrtf(FFTLEN);
   }
+  // fftfreqtab is in bins at 55467 Hz
+  unsigned srate = idata->srate ? idata->srate : 55467;
   float dbuf[FFTDISPLEN];
   for (int i = 0; i < FFTDISPLEN; i++) {
+    unsigned start = fftfreqtab[i] * 55467u / srate;
+    unsigned end = fftfreqtab[i+1] * 55467u / srate;
     dbuf[i] = 0.0f;
-    for (int j = fftfreqtab[i]; j < fftfreqtab[i+1]; j++) {
+    for (unsigned j = start; j < end; j++) {
       dbuf[i] += idata->fwork[j];
     }
-    dbuf[i] /= fftfreqtab[i+1] - fftfreqtab[i];
+    dbuf[i] /= end - start;
   }
   for (int i = 0; i < FFTDISPLEN; i++) {
     float res = (dbuf[i] > (1.0f / 256)) ? (4.0f*log2f(dbuf[i]) + 32.0f) : 0.0f;
@@ -5,16 +5,24 @@
 
 enum {
   FFTLEN = 8192,
+  // samples kept after the analysis window for fmplayer_fft_input_data.delay
+  FFTDELAYMAX = 8192,
+  FFTBUFLEN = FFTLEN + FFTDELAYMAX,
   FFTDISPLEN = 70,
 };
 
 struct fmplayer_fft_data {
-  int16_t buf[FFTLEN];
+  int16_t buf[FFTBUFLEN];
   unsigned ind;
 };
 
 struct fmplayer_fft_input_data {
   struct fmplayer_fft_data fdata;
+  // the newest samples in fdata which are not heard yet (up to FFTDELAYMAX),
+  // the analysis window ends before them
+  unsigned delay;
+  // rate of the samples in fdata, 0 for 55467 Hz
+  unsigned srate;
   int16_t work[FFTLEN];
   double dwork[FFTLEN];
   float fwork[FFTLEN*2];
@@ -29,6 +37,8 @@ struct fmplayer_fft_disp_data {
 void fft_init_table(void);
 
 void fft_write(struct fmplayer_fft_data *data, const int16_t *buf, unsigned len);
+// float planar input from opna_timer_mix_f32
+void fft_write_f32(struct fmplayer_fft_data *data, const float *l, const float *r, unsigned len);
 
 void fft_calc(struct fmplayer_fft_disp_data *ddata, struct fmplayer_fft_input_data *idata);
 
@@ -135,6 +135,9 @@ struct fmdriver_work {
   uint32_t timerb_cnt_loop;
   // loop length, calculated before playing
   uint32_t loop_timerb_cnt;
+  // set before driver init to only follow the command streams
+  // (no effects, register output or status update), for loop length calculation
+  bool loop_analysis;
   // fm3ex part map
   bool playing;
   bool paused;
@@ -2893,6 +2893,25 @@ static void fmp_timerb(struct fmdriver_work *work, struct driver_fmp *fmp) {
     fmp->clock_divider = 10;
   }
   // 1840
+  if (work->loop_analysis) {
+    // only advance the command streams, in the same order as below
+    static const uint8_t analysis_parts[] = {
+      FMP_PART_FM_1, FMP_PART_FM_2, FMP_PART_FM_3,
+      FMP_PART_FM_4, FMP_PART_FM_5, FMP_PART_FM_6,
+      FMP_PART_ADPCM,
+      FMP_PART_SSG_1, FMP_PART_SSG_2, FMP_PART_SSG_3,
+      FMP_PART_FM_EX1, FMP_PART_FM_EX2, FMP_PART_FM_EX3,
+    };
+    for (unsigned i = 0; i < sizeof(analysis_parts); i++) {
+      struct fmp_part *part = &fmp->parts[analysis_parts[i]];
+      if (part->status.off) continue;
+      fmp_part_cmd(work, fmp, part);
+    }
+    if (!fmp->rhythm.status) {
+      fmp_part_cmd_rhythm(work, fmp);
+    }
+    return;
+  }
   for (int p = 0; p < 6; p++) {
     struct fmp_part *part = &fmp->parts[FMP_PART_FM_1+p];
     if (part->status.off) continue;
@@ -3605,7 +3624,7 @@ void fmp_init(struct fmdriver_work *work, struct driver_fmp *fmp) {
 
 // 4235
 bool fmp_adpcm_load(struct fmdriver_work *work,
-                    uint8_t *data, size_t datalen) {
+                    const uint8_t *data, size_t datalen) {
   if (datalen < 0x210) return false;
   if (datalen > (0x210+(1<<18))) return false;
   struct driver_fmp *fmp = (struct driver_fmp *)work->driver;
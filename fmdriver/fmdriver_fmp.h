@@ -555,7 +555,7 @@ void fmp_init(struct fmdriver_work *work, struct driver_fmp *fmp);
 // load adpcm data
 // this function will access opna
 bool fmp_adpcm_load(struct fmdriver_work *work,
-                    uint8_t *data, size_t datalen);
+                    const uint8_t *data, size_t datalen);
 
 // 1da8
 // 6190: fmp external characters
@@ -5904,7 +5904,7 @@ static void pmd_opna_interrupt(struct fmdriver_work *work) {
     }
   }
   // 3cc0
-  pmd_work_status_update(work, pmd);
+  if (!work->loop_analysis) pmd_work_status_update(work, pmd);
 }
 
 /*
@@ -6027,6 +6027,12 @@ void pmd_init(struct fmdriver_work *work,
   pmd_reset_timer(work, pmd);
   pmd->playing = true;
   work->driver_opna_interrupt = pmd_opna_interrupt;
+  if (work->loop_analysis) {
+    // masked parts keep the timing but skip LFO, envelope and register output
+    for (int i = 0; i < PMD_PART_NUM; i++) {
+      pmd->parts[i].mask.ff = true;
+    }
+  }
 
   /*
   static const int memotable[3] = {1, 4, 5};
@@ -6077,7 +6083,7 @@ enum {
 
 bool pmd_ppc_load(
   struct fmdriver_work *work,
-  uint8_t *data, size_t datalen
+  const uint8_t *data, size_t datalen
 ) {
   struct driver_pmd *pmd = (struct driver_pmd *)work->driver;
   if (datalen < PPC_HEADER_SIZE) return false;
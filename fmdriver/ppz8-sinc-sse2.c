@@ -0,0 +1,27 @@
+#include "ppz8.h"
+#include <emmintrin.h>
+
+void ppz8_sinc_calc_sse2(const int16_t *data, uint64_t ptr, uint64_t ptrdiff,
+                         int32_t *out, unsigned samples) {
+  unsigned i = 0;
+  for (; i + 4 <= samples; i += 4) {
+    // 4 output samples per loop
+    __m128i acc[4];
+    for (int k = 0; k < 4; k++) {
+      __m128i in = _mm_loadu_si128((const __m128i *)&data[(ptr >> 16) - 3]);
+      __m128i sinc = _mm_loadu_si128((const __m128i *)ppz8_sinctable[(ptr >> 8) & 0xff]);
+      acc[k] = _mm_madd_epi16(in, sinc);
+      ptr += ptrdiff;
+    }
+    __m128i t0 = _mm_add_epi32(_mm_unpacklo_epi32(acc[0], acc[1]),
+                               _mm_unpackhi_epi32(acc[0], acc[1]));
+    __m128i t1 = _mm_add_epi32(_mm_unpacklo_epi32(acc[2], acc[3]),
+                               _mm_unpackhi_epi32(acc[2], acc[3]));
+    __m128i sum = _mm_add_epi32(_mm_unpacklo_epi64(t0, t1),
+                                _mm_unpackhi_epi64(t0, t1));
+    _mm_storeu_si128((__m128i *)&out[i], _mm_srai_epi32(sum, 15));
+  }
+  if (i < samples) {
+    ppz8_sinc_calc_c(data, ptr, ptrdiff, out + i, samples - i);
+  }
+}
@@ -0,0 +1,27 @@
+#include "ppz8.h"
+#include <wasm_simd128.h>
+
+void ppz8_sinc_calc_wasm(const int16_t *data, uint64_t ptr, uint64_t ptrdiff,
+                         int32_t *out, unsigned samples) {
+  unsigned i = 0;
+  for (; i + 4 <= samples; i += 4) {
+    // 4 output samples per loop
+    v128_t acc[4];
+    for (int k = 0; k < 4; k++) {
+      v128_t in = wasm_v128_load(&data[(ptr >> 16) - 3]);
+      v128_t sinc = wasm_v128_load(ppz8_sinctable[(ptr >> 8) & 0xff]);
+      acc[k] = wasm_i32x4_dot_i16x8(in, sinc);
+      ptr += ptrdiff;
+    }
+    v128_t t0 = wasm_i32x4_add(wasm_i32x4_shuffle(acc[0], acc[1], 0, 4, 1, 5),
+                               wasm_i32x4_shuffle(acc[0], acc[1], 2, 6, 3, 7));
+    v128_t t1 = wasm_i32x4_add(wasm_i32x4_shuffle(acc[2], acc[3], 0, 4, 1, 5),
+                               wasm_i32x4_shuffle(acc[2], acc[3], 2, 6, 3, 7));
+    v128_t sum = wasm_i32x4_add(wasm_i64x2_shuffle(t0, t1, 0, 2),
+                                wasm_i64x2_shuffle(t0, t1, 1, 3));
+    wasm_v128_store(&out[i], wasm_i32x4_shr(sum, 15));
+  }
+  if (i < samples) {
+    ppz8_sinc_calc_c(data, ptr, ptrdiff, out + i, samples - i);
+  }
+}
@@ -3,6 +3,16 @@
 #include <string.h>
 #include "ppz8-sinctable.inc"
 
+#ifdef ENABLE_SSE
+// only enabled when the target always has SSE2
+ppz8_sinc_calc_func_type ppz8_sinc_calc_func = ppz8_sinc_calc_sse2;
+#elif defined(ENABLE_WASM_SIMD)
+// simd128 cannot be detected at runtime, the module does not load without it
+ppz8_sinc_calc_func_type ppz8_sinc_calc_func = ppz8_sinc_calc_wasm;
+#else
+ppz8_sinc_calc_func_type ppz8_sinc_calc_func = ppz8_sinc_calc_c;
+#endif
+
 unsigned ppz8_get_mask(const struct ppz8 *ppz8) {
   return ppz8->mask;
 }
@@ -10,6 +20,46 @@ void ppz8_set_mask(struct ppz8 *ppz8, unsigned mask) {
   ppz8->mask = mask & 0xffu;
 }
 
+static void ppz8_channel_update(const struct ppz8 *ppz8, struct ppz8_channel *channel) {
+  const struct ppz8_pcmbuf *buf = &ppz8->buf[channel->voice>>7];
+  const struct ppz8_pcmvoice *voice = &buf->voice[channel->voice & 0x7f];
+  channel->ptrdiff = (((uint64_t)channel->freq * voice->origfreq) << 1) / ppz8->srate;
+  // same conditions as ppz8_loop
+  uint64_t limit = channel->endptr;
+  if (channel->loopstartptr != (uint64_t)-1) {
+    uint64_t loopendptr = (channel->loopendptr == (uint64_t)-1) ?
+        channel->endptr : channel->loopendptr;
+    if ((channel->loopendptr != (uint64_t)-1) &&
+        (channel->loopendptr > channel->endptr)) {
+      limit = channel->loopendptr;
+    }
+    if (loopendptr < limit) limit = loopendptr;
+  }
+  channel->looplimit = limit;
+}
+
+// after voices change
+static void ppz8_channels_update(struct ppz8 *ppz8) {
+  for (int i = 0; i < 8; i++) {
+    ppz8_channel_update(ppz8, &ppz8->channel[i]);
+  }
+}
+
+static void ppz8_cache_flush(struct ppz8_cache *cache) {
+  cache->block_top = 0;
+  cache->freeblock = PPZ8_CACHE_NOBLOCK;
+  cache->entry_cnt = 0;
+  for (unsigned i = 0; i < PPZ8_CACHE_ENTRIES; i++) {
+    cache->entry[i].used = false;
+  }
+}
+
+// after PCM data is loaded
+static void ppz8_voices_changed(struct ppz8 *ppz8) {
+  ppz8_channels_update(ppz8);
+  if (ppz8->cache) ppz8_cache_flush(ppz8->cache);
+}
+
 void ppz8_init(struct ppz8 *ppz8, uint16_t srate, uint16_t mix_volume) {
   for (int i = 0; i < 2; i++) {
     struct ppz8_pcmbuf *buf = &ppz8->buf[i];
@@ -27,6 +77,7 @@ void ppz8_init(struct ppz8 *ppz8, uint16_t srate, uint16_t mix_volume) {
   for (int i = 0; i < 8; i++) {
     struct ppz8_channel *channel = &ppz8->channel[i];
     channel->ptr = -1;
+    channel->startptr = -1;
     channel->loopstartptr = -1;
     channel->loopendptr = -1;
     channel->endptr = 0;
@@ -43,6 +94,8 @@ void ppz8_init(struct ppz8 *ppz8, uint16_t srate, uint16_t mix_volume) {
   ppz8->totalvol = 12;
   ppz8->mix_volume = mix_volume;
   ppz8->interp = PPZ8_INTERP_SINC;
+  ppz8->cache = 0;
+  ppz8_channels_update(ppz8);
 }
 
 static uint64_t ppz8_loop(const struct ppz8_channel *channel, uint64_t ptr) {
@@ -148,39 +201,322 @@ static int32_t ppz8_channel_calc_sinc(struct ppz8 *ppz8, struct ppz8_channel *ch
   return out;
 }
 
-static int32_t ppz8_channel_calc(struct ppz8 *ppz8, struct ppz8_channel *channel) {
-  struct ppz8_pcmbuf *buf = &ppz8->buf[channel->voice>>7];
-  struct ppz8_pcmvoice *voice = &buf->voice[channel->voice & 0x7f];
-  int32_t out = 0;
-  if (channel->vol) {
-    switch (ppz8->interp) {
-    case PPZ8_INTERP_SINC:
-      out = ppz8_channel_calc_sinc(ppz8, channel);
-      break;
-    case PPZ8_INTERP_LINEAR:
-      out = ppz8_channel_calc_linear(ppz8, channel);
-      break;
-    default:
-      out = ppz8_channel_calc_nearest_neighbor(ppz8, channel);
-      break;
-    }
-    // volume: out * 2**((volume-15)/2)
-    out >>= (7 - ((channel->vol&0xf)>>1));
-    if (!(channel->vol&1)) {
-      out *= 0xb505;
-      out >>= 16;
+void ppz8_sinc_calc_c(const int16_t *data, uint64_t ptr, uint64_t ptrdiff,
+                      int32_t *out, unsigned samples) {
+  for (unsigned i = 0; i < samples; i++) {
+    const int16_t *in = &data[(ptr >> 16) - 3];
+    const int16_t *sinctable = ppz8_sinctable[(ptr >> 8) & 0xff];
+    int32_t o = 0;
+    for (int j = 0; j < 7; j++) {
+      o += in[j] * sinctable[j];
     }
+    out[i] = o >> 15;
+    ptr += ptrdiff;
   }
+}
+
+static int32_t ppz8_channel_scale(const struct ppz8_channel *channel, int32_t out) {
+  // volume: out * 2**((volume-15)/2)
+  out >>= (7 - ((channel->vol&0xf)>>1));
+  if (!(channel->vol&1)) {
+    out *= 0xb505;
+    out >>= 16;
+  }
+  return out;
+}
 
-  uint64_t ptrdiff = (((uint64_t)channel->freq * voice->origfreq) << 1) / ppz8->srate;
-  uint64_t newptr = channel->ptr + ptrdiff;
+static void ppz8_channel_advance(struct ppz8_channel *channel) {
+  uint64_t newptr = channel->ptr + channel->ptrdiff;
+  if (newptr < channel->looplimit) {
+    channel->ptr = newptr;
+    return;
+  }
   channel->ptr = ppz8_loop(channel, newptr);
   if (newptr != channel->ptr) channel->looped = true;
   if (channel->ptr == (uint64_t)-1) channel->playing = false;
-  return out;
+}
+
+// fast path of ppz8_channel_calc_raw with sinc interpolation:
+// while all 7 taps are inside the sample data and the pointer does not
+// reach a loop point or the end, ppz8_channel_get_centered_samples reads
+// data[ind-3] to data[ind+3] as is, so they can be read directly for
+// several output samples at once.
+// returns the number of samples calculated, 0 if the pointer is near a
+// loop point or the end
+static unsigned ppz8_channel_calc_sinc_span(struct ppz8 *ppz8,
+                                            struct ppz8_channel *channel,
+                                            int32_t *out, unsigned samples) {
+  const struct ppz8_pcmbuf *buf = &ppz8->buf[channel->voice>>7];
+  if (!buf->data) return 0;
+  uint64_t ptr = channel->ptr;
+  uint32_t currind = ptr >> 16;
+  bool loop = channel->loopstartptr != (uint64_t)-1;
+  uint64_t loopendptr = (channel->loopendptr == (uint64_t)-1) ?
+      channel->endptr : channel->loopendptr;
+  // taps before the pointer
+  if (currind < 3) return 0;
+  if (loop && channel->looped &&
+      (currind - 3 < (uint32_t)(channel->loopstartptr >> 16))) return 0;
+  // the pointer index has to stay below indlimit:
+  // taps after the pointer (and the 8th zero tap read by SIMD kernels)
+  uint32_t indlimit = channel->endptr >> 16;
+  if (buf->buflen < indlimit) indlimit = buf->buflen;
+  if (indlimit < 5) return 0;
+  indlimit -= 4;
+  if (loop) {
+    // compared without shifting in ppz8_channel_get_centered_samples
+    uint32_t loopendraw = loopendptr;
+    if (loopendraw < 3) return 0;
+    if (loopendraw - 3 < indlimit) indlimit = loopendraw - 3;
+    if (channel->looped) {
+      uint32_t loopendind = loopendptr >> 16;
+      if (loopendind + 1 < indlimit) indlimit = loopendind + 1;
+    }
+  }
+  uint64_t ptrlimit = ((uint64_t)indlimit) << 16;
+  if (channel->looplimit < ptrlimit) ptrlimit = channel->looplimit;
+  if (ptr >= ptrlimit) return 0;
+
+  uint64_t ptrdiff = channel->ptrdiff;
+  unsigned n = samples;
+  if (ptrdiff) {
+    uint64_t span = (ptrlimit - 1 - ptr) / ptrdiff + 1;
+    if (span < n) n = span;
+  }
+  ppz8_sinc_calc_func(buf->data, ptr, ptrdiff, out, n);
+  channel->ptr = ptr + (n - 1) * ptrdiff;
+  ppz8_channel_advance(channel);
+  return n;
+}
+
+// interpolated output before volume, advances the pointer
+// returns the number of samples calculated (at least 1)
+static unsigned ppz8_channel_calc_raw(struct ppz8 *ppz8,
+                                      struct ppz8_channel *channel,
+                                      int32_t *out, unsigned samples) {
+  switch (ppz8->interp) {
+  case PPZ8_INTERP_SINC:
+    {
+      unsigned n = ppz8_channel_calc_sinc_span(ppz8, channel, out, samples);
+      if (n) return n;
+    }
+    out[0] = ppz8_channel_calc_sinc(ppz8, channel);
+    break;
+  case PPZ8_INTERP_LINEAR:
+    out[0] = ppz8_channel_calc_linear(ppz8, channel);
+    break;
+  default:
+    out[0] = ppz8_channel_calc_nearest_neighbor(ppz8, channel);
+    break;
+  }
+  ppz8_channel_advance(channel);
+  return 1;
+}
+
+void ppz8_cache_init(struct ppz8_cache *cache, int16_t *mem, size_t memlen) {
+  size_t blocks = memlen / PPZ8_CACHE_BLOCK;
+  cache->mem = mem;
+  cache->block_cnt = blocks < PPZ8_CACHE_BLOCKS ? blocks : PPZ8_CACHE_BLOCKS;
+  cache->clock = 0;
+  cache->stats = (struct ppz8_cache_stats){0};
+  ppz8_cache_flush(cache);
+}
+
+void ppz8_set_cache(struct ppz8 *ppz8, struct ppz8_cache *cache) {
+  ppz8->cache = cache;
+  if (cache) ppz8_cache_flush(cache);
+}
+
+static unsigned ppz8_cache_block_alloc(struct ppz8_cache *cache) {
+  unsigned block = cache->freeblock;
+  if (block != PPZ8_CACHE_NOBLOCK) {
+    cache->freeblock = cache->next[block];
+  } else if (cache->block_top < cache->block_cnt) {
+    block = cache->block_top++;
+  }
+  return block;
+}
+
+// hand the blocks of the entry back in one step
+static void ppz8_cache_release(struct ppz8_cache *cache,
+                               struct ppz8_cache_entry *entry) {
+  if (entry->filled && !entry->wide) {
+    cache->next[entry->last] = cache->freeblock;
+    cache->freeblock = entry->first;
+  }
+  entry->filled = 0;
+}
+
+static void ppz8_cache_evict(struct ppz8_cache *cache,
+                             struct ppz8_cache_entry *entry) {
+  ppz8_cache_release(cache, entry);
+  entry->used = false;
+  cache->entry_cnt--;
+  cache->stats.evictions++;
+}
+
+// drop the least recently used entry other than keep,
+// false if there is none
+static bool ppz8_cache_evict_lru(struct ppz8_cache *cache,
+                                 const struct ppz8_cache_entry *keep) {
+  struct ppz8_cache_entry *lru = 0;
+  for (unsigned i = 0; i < PPZ8_CACHE_ENTRIES; i++) {
+    struct ppz8_cache_entry *entry = &cache->entry[i];
+    if (!entry->used || entry == keep) continue;
+    if (!lru || entry->lastuse < lru->lastuse) lru = entry;
+  }
+  if (!lru) return false;
+  ppz8_cache_evict(cache, lru);
+  return true;
+}
+
+static struct ppz8_cache_entry *ppz8_cache_find(struct ppz8_cache *cache,
+                                                const struct ppz8_cache_entry *key) {
+  for (unsigned i = 0; i < PPZ8_CACHE_ENTRIES; i++) {
+    struct ppz8_cache_entry *entry = &cache->entry[i];
+    if (entry->used &&
+        entry->startptr == key->startptr &&
+        entry->ptrdiff == key->ptrdiff &&
+        entry->endptr == key->endptr &&
+        entry->data == key->data &&
+        entry->buflen == key->buflen &&
+        entry->interp == key->interp) return entry;
+  }
+  return 0;
+}
+
+// blocks are taken as ppz8_channel_calc_cached fills the entry
+static struct ppz8_cache_entry *ppz8_cache_add(struct ppz8_cache *cache,
+                                               const struct ppz8_cache_entry *key) {
+  if (key->len > (uint64_t)cache->block_cnt * PPZ8_CACHE_BLOCK) return 0;
+  if (cache->entry_cnt == PPZ8_CACHE_ENTRIES) ppz8_cache_evict_lru(cache, 0);
+  struct ppz8_cache_entry *entry = cache->entry;
+  while (entry->used) entry++;
+  *entry = *key;
+  entry->filled = 0;
+  entry->used = true;
+  entry->wide = false;
+  cache->entry_cnt++;
+  return entry;
+}
+
+// block holding sample pos of the entry
+static unsigned ppz8_cache_entry_block(const struct ppz8_cache *cache,
+                                       const struct ppz8_cache_entry *entry,
+                                       uint32_t pos) {
+  unsigned block = entry->first;
+  for (uint32_t i = pos / PPZ8_CACHE_BLOCK; i; i--) {
+    block = cache->next[block];
+  }
+  return block;
+}
+
+// one-shot voices played from the start with the same pitch produce the same
+// output, so it is stored while it is played and read from the cache after that
+// returns the number of samples calculated, 0 if the cache is not used
+static unsigned ppz8_channel_calc_cached(struct ppz8 *ppz8,
+                                        struct ppz8_channel *channel,
+                                        int32_t *out, unsigned samples) {
+  struct ppz8_cache *cache = ppz8->cache;
+  if (channel->loopstartptr != (uint64_t)-1) return 0;
+  uint64_t ptrdiff = channel->ptrdiff;
+  if (!ptrdiff || channel->ptr < channel->startptr) return 0;
+  uint64_t pos = channel->ptr - channel->startptr;
+  if (pos % ptrdiff) return 0;
+  pos /= ptrdiff;
+  const struct ppz8_pcmbuf *buf = &ppz8->buf[channel->voice>>7];
+  uint64_t len = (channel->startptr < channel->endptr) ?
+      (channel->endptr - 1 - channel->startptr) / ptrdiff + 1 : 1;
+  if (len > UINT32_MAX || pos >= len) return 0;
+  struct ppz8_cache_entry key = {
+    .data = buf->data,
+    .buflen = buf->buflen,
+    .interp = ppz8->interp,
+    .startptr = channel->startptr,
+    .endptr = channel->endptr,
+    .ptrdiff = ptrdiff,
+    .len = len,
+  };
+  struct ppz8_cache_entry *entry = ppz8_cache_find(cache, &key);
+  if (!entry) {
+    // only added when the voice starts
+    if (pos) return 0;
+    cache->stats.misses++;
+    entry = ppz8_cache_add(cache, &key);
+    if (!entry) return 0;
+  } else if (!pos) {
+    cache->stats.hits++;
+  }
+  entry->lastuse = ++cache->clock;
+  if (entry->wide || pos > entry->filled) return 0;
+  unsigned n = samples;
+  unsigned blockleft = PPZ8_CACHE_BLOCK - pos % PPZ8_CACHE_BLOCK;
+  if (blockleft < n) n = blockleft;
+  if (pos == entry->filled) {
+    // first time here, calculate and append to the entry
+    unsigned block;
+    if (pos % PPZ8_CACHE_BLOCK) {
+      block = entry->last;
+    } else {
+      // the whole voice fits in the cache (checked in ppz8_cache_add),
+      // so evicting the others always frees a block
+      while ((block = ppz8_cache_block_alloc(cache)) == PPZ8_CACHE_NOBLOCK) {
+        if (!ppz8_cache_evict_lru(cache, entry)) return 0;
+      }
+      if (pos) cache->next[entry->last] = block;
+      else entry->first = block;
+      entry->last = block;
+    }
+    if (entry->len - pos < n) n = entry->len - pos;
+    n = ppz8_channel_calc_raw(ppz8, channel, out, n);
+    int16_t *cached = &cache->mem[block * PPZ8_CACHE_BLOCK + pos % PPZ8_CACHE_BLOCK];
+    bool wide = false;
+    for (unsigned i = 0; i < n; i++) {
+      if (out[i] < INT16_MIN || out[i] > INT16_MAX) wide = true;
+      cached[i] = out[i];
+      out[i] = ppz8_channel_scale(channel, out[i]);
+    }
+    if (wide) {
+      // keep the entry without samples so that it is not added again
+      entry->filled += n;
+      ppz8_cache_release(cache, entry);
+      entry->wide = true;
+    } else {
+      entry->filled += n;
+    }
+    return n;
+  }
+  if (entry->filled - pos < n) n = entry->filled - pos;
+  unsigned block = ppz8_cache_entry_block(cache, entry, pos);
+  const int16_t *in = &cache->mem[block * PPZ8_CACHE_BLOCK + pos % PPZ8_CACHE_BLOCK];
+  for (unsigned i = 0; i < n; i++) {
+    out[i] = ppz8_channel_scale(channel, in[i]);
+  }
+  channel->ptr += (n - 1) * ptrdiff;
+  ppz8_channel_advance(channel);
+  return n;
 }
 
 void ppz8_mix(struct ppz8 *ppz8, int16_t *buf, unsigned samples) {
+  int32_t acc[PPZ8_MIX32_CHUNK*2];
+  while (samples) {
+    unsigned chunk = samples < PPZ8_MIX32_CHUNK ? samples : PPZ8_MIX32_CHUNK;
+    for (unsigned i = 0; i < chunk*2; i++) {
+      acc[i] = buf[i];
+    }
+    ppz8_mix32(ppz8, acc, chunk);
+    for (unsigned i = 0; i < chunk*2; i++) {
+      int32_t o = acc[i];
+      if (o < INT16_MIN) o = INT16_MIN;
+      if (o > INT16_MAX) o = INT16_MAX;
+      buf[i] = o;
+    }
+    buf += chunk*2;
+    samples -= chunk;
+  }
+}
+
+void ppz8_mix32(struct ppz8 *ppz8, int32_t *buf, unsigned samples) {
   unsigned level[8] = {0};
   static const uint8_t pan_vol[10][2] = {
     {0, 0},
@@ -194,29 +530,49 @@ void ppz8_mix(struct ppz8 *ppz8, int16_t *buf, unsigned samples) {
     {1, 4},
     {0, 4}
   };
-  for (unsigned i = 0; i < samples; i++) {
-    int32_t lo = buf[i*2+0];
-    int32_t ro = buf[i*2+1];
+  // channels are calculated one at a time, registers do not change
+  // during a call
+  int32_t chbuf[PPZ8_MIX32_CHUNK];
+  while (samples) {
+    unsigned chunk = samples < PPZ8_MIX32_CHUNK ? samples : PPZ8_MIX32_CHUNK;
     for (int p = 0; p < 8; p++) {
       struct ppz8_channel *channel = &ppz8->channel[p];
-      if (!channel->playing) continue;
-      int32_t out = ppz8_channel_calc(ppz8, channel);
-      {
+      unsigned done = 0;
+      while (done < chunk && channel->playing) {
+        unsigned n = 0;
+        if (!channel->vol) {
+          chbuf[done] = 0;
+          ppz8_channel_advance(channel);
+          n = 1;
+        } else {
+          if (ppz8->cache) {
+            n = ppz8_channel_calc_cached(ppz8, channel, &chbuf[done], chunk - done);
+          }
+          if (!n) {
+            n = ppz8_channel_calc_raw(ppz8, channel, &chbuf[done], chunk - done);
+            for (unsigned i = done; i < done + n; i++) {
+              chbuf[i] = ppz8_channel_scale(channel, chbuf[i]);
+            }
+          }
+        }
+        done += n;
+      }
+      for (unsigned i = 0; i < done; i++) {
+        int32_t out = chbuf[i];
         unsigned uout = out > 0 ? out : -out;
         if (uout > level[p]) level[p] = uout;
       }
       if ((1u << p) & (ppz8->mask)) continue;
-      out *= ppz8->mix_volume;
-      out >>= 15;
-      lo += (out * pan_vol[channel->pan][0]) >> 2;
-      ro += (out * pan_vol[channel->pan][1]) >> 2;
+      for (unsigned i = 0; i < done; i++) {
+        int32_t out = chbuf[i];
+        out *= ppz8->mix_volume;
+        out >>= 15;
+        buf[i*2+0] += (out * pan_vol[channel->pan][0]) >> 2;
+        buf[i*2+1] += (out * pan_vol[channel->pan][1]) >> 2;
+      }
     }
-    if (lo < INT16_MIN) lo = INT16_MIN;
-    if (lo > INT16_MAX) lo = INT16_MAX;
-    if (ro < INT16_MIN) ro = INT16_MIN;
-    if (ro > INT16_MAX) ro = INT16_MAX;
-    buf[i*2+0] = lo;
-    buf[i*2+1] = ro;
+    buf += chunk*2;
+    samples -= chunk;
   }
   for (int p = 0; p < 8; p++) {
     leveldata_update(&ppz8->channel[p].leveldata, level[p]);
@@ -243,12 +599,12 @@ static uint16_t calc_adpcmd(uint16_t adpcmd, uint8_t data) {
   return newadpcmd;
 }
 
-bool ppz8_pvi_load(struct ppz8 *ppz8, uint8_t bnum,
-                   const uint8_t *pvidata, uint32_t pvidatalen,
-                   int16_t *decodebuf) {
-  if (bnum >= 2) return false;
+bool ppz8_pvi_decode(struct ppz8_pcmbuf *buf,
+                     const uint8_t *pvidata, uint32_t pvidatalen,
+                     int16_t *decodebuf) {
   //if (pvidatalen > (0x210+(1<<18))) return false;
-  struct ppz8_pcmbuf *buf = &ppz8->buf[bnum];
+  if (pvidatalen < 0x210) return false;
+  memset(buf, 0, sizeof(*buf));
   //uint16_t origfreq = ((uint32_t)read16le(&pvidata[0x8]) * 55467) >> 16;
   uint16_t origfreq = (0x49ba*55467)>>16;
   uint32_t lastaddr = 0;
@@ -285,13 +641,12 @@ bool ppz8_pvi_load(struct ppz8 *ppz8, uint8_t bnum,
   return true;
 }
 
-bool ppz8_pzi_load(struct ppz8 *ppz8, uint8_t bnum,
-                   const uint8_t *pzidata, uint32_t pzidatalen,
-                   int16_t *decodebuf) {
-  if (bnum >= 2) return false;
+bool ppz8_pzi_decode(struct ppz8_pcmbuf *buf,
+                     const uint8_t *pzidata, uint32_t pzidatalen,
+                     int16_t *decodebuf) {
   if (pzidatalen < (0x20+(18*128))) return false;
   if (memcmp(pzidata, "PZI0", 4) && memcmp(pzidata, "PZI1", 4)) return false;
-  struct ppz8_pcmbuf *buf = &ppz8->buf[bnum];
+  memset(buf, 0, sizeof(*buf));
   for (int i = 0; i < 0x80; i++) {
     struct ppz8_pcmvoice *voice = &buf->voice[i];
     voice->start = read32le(&pzidata[0x20+18*i+0]) * 2;
@@ -312,6 +667,33 @@ bool ppz8_pzi_load(struct ppz8 *ppz8, uint8_t bnum,
   return true;
 }
 
+bool ppz8_pvi_load(struct ppz8 *ppz8, uint8_t bnum,
+                   const uint8_t *pvidata, uint32_t pvidatalen,
+                   int16_t *decodebuf) {
+  if (bnum >= 2) return false;
+  struct ppz8_pcmbuf buf;
+  if (!ppz8_pvi_decode(&buf, pvidata, pvidatalen, decodebuf)) return false;
+  ppz8_set_pcmbuf(ppz8, bnum, &buf);
+  return true;
+}
+
+bool ppz8_pzi_load(struct ppz8 *ppz8, uint8_t bnum,
+                   const uint8_t *pzidata, uint32_t pzidatalen,
+                   int16_t *decodebuf) {
+  if (bnum >= 2) return false;
+  struct ppz8_pcmbuf buf;
+  if (!ppz8_pzi_decode(&buf, pzidata, pzidatalen, decodebuf)) return false;
+  ppz8_set_pcmbuf(ppz8, bnum, &buf);
+  return true;
+}
+
+void ppz8_set_pcmbuf(struct ppz8 *ppz8, uint8_t bnum,
+                     const struct ppz8_pcmbuf *pcmbuf) {
+  if (bnum >= 2) return;
+  ppz8->buf[bnum] = *pcmbuf;
+  ppz8_voices_changed(ppz8);
+}
+
 static void ppz8_channel_play(struct ppz8 *ppz8, uint8_t ch, uint8_t v) {
   if (ch >= 8) return;
   struct ppz8_channel *channel = &ppz8->channel[ch];
@@ -319,6 +701,7 @@ static void ppz8_channel_play(struct ppz8 *ppz8, uint8_t ch, uint8_t v) {
   struct ppz8_pcmbuf *buf = &ppz8->buf[channel->voice>>7];
   struct ppz8_pcmvoice *voice = &buf->voice[channel->voice & 0x7f];
   channel->ptr = ((uint64_t)(voice->start)>>1)<<16;
+  channel->startptr = channel->ptr;
   channel->endptr = ((uint64_t)(voice->start+voice->len)>>1)<<16;
 /*  
   channel->loopstartptr = ((uint64_t)(voice->loopstart)>>1)<<16;
@@ -330,6 +713,7 @@ static void ppz8_channel_play(struct ppz8 *ppz8, uint8_t ch, uint8_t v) {
     : channel->ptr + (((uint64_t)(channel->loopendoff))<<16);
   channel->playing = true;
   channel->looped = false;
+  ppz8_channel_update(ppz8, channel);
 }
 
 static void ppz8_channel_stop(struct ppz8 *ppz8, uint8_t ch) {
@@ -350,6 +734,7 @@ static void ppz8_channel_freq(struct ppz8 *ppz8, uint8_t ch, uint32_t freq) {
   if (ch >= 8) return;
   struct ppz8_channel *channel = &ppz8->channel[ch];
   channel->freq = freq;
+  ppz8_channel_update(ppz8, channel);
 }
 
 static void ppz8_channel_loopoffset(struct ppz8 *ppz8, uint8_t ch,
@@ -1,6 +1,7 @@
 #ifndef MYON_PPZ8_H_INCLUDED
 #define MYON_PPZ8_H_INCLUDED
 
+#include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include <stdatomic.h>
@@ -10,6 +11,16 @@
 extern "C" {
 #endif
 
+enum {
+  PPZ8_MIX32_CHUNK = 256,
+  PPZ8_CACHE_ENTRIES = 128,
+  // samples are stored in blocks of this many samples
+  PPZ8_CACHE_BLOCK = 1024,
+  // mem beyond this many blocks is not used
+  PPZ8_CACHE_BLOCKS = 4096,
+  PPZ8_CACHE_NOBLOCK = 0xffff,
+};
+
 enum ppz8_interp {
   PPZ8_INTERP_NONE,
   PPZ8_INTERP_LINEAR,
@@ -32,6 +43,7 @@ struct ppz8_pcmbuf {
 
 struct ppz8_channel {
   uint64_t ptr;
+  uint64_t startptr;
   uint64_t loopstartptr;
   uint64_t loopendptr;
   uint64_t endptr;
@@ -44,6 +56,61 @@ struct ppz8_channel {
   bool playing;
   bool looped;
   struct leveldata leveldata;
+  // cached from freq, voice and the pointers above when they change
+  uint64_t ptrdiff;
+  // pointers below this are not changed by looping or the end
+  uint64_t looplimit;
+};
+
+struct ppz8_cache_stats {
+  // one-shot voices started from the cache / rendered into it
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t evictions;
+};
+
+struct ppz8_cache_entry {
+  // key
+  const int16_t *data;
+  uint32_t buflen;
+  enum ppz8_interp interp;
+  uint64_t startptr;
+  uint64_t endptr;
+  uint64_t ptrdiff;
+
+  uint64_t lastuse;
+  // output samples, filled up to filled as the voice plays,
+  // a block is taken for each PPZ8_CACHE_BLOCK samples
+  // from first to last, chained by next in struct ppz8_cache
+  uint32_t len;
+  uint32_t filled;
+  uint16_t first;
+  uint16_t last;
+  bool used;
+  // output does not fit in int16, the samples are dropped
+  bool wide;
+};
+
+// interpolated output (before volume) of one-shot voices, for voices
+// retriggered at the same pitch
+// the output is stored while the voice is played for the first time,
+// so filling the cache costs no more than calculating the voice
+// mem is provided by the caller and its size is the cap of the cache,
+// least recently used voices are dropped when it is full
+// entries and blocks are freed in place, nothing is moved
+// one cache can only be used by one struct ppz8
+struct ppz8_cache {
+  int16_t *mem;
+  unsigned block_cnt;
+  // blocks below this have been taken at least once,
+  // freed ones are chained from freeblock
+  unsigned block_top;
+  uint16_t freeblock;
+  unsigned entry_cnt;
+  uint64_t clock;
+  struct ppz8_cache_stats stats;
+  struct ppz8_cache_entry entry[PPZ8_CACHE_ENTRIES];
+  uint16_t next[PPZ8_CACHE_BLOCKS];
 };
 
 struct ppz8 {
@@ -54,16 +121,33 @@ struct ppz8 {
   uint16_t mix_volume;
   unsigned mask;
   enum ppz8_interp interp;
+  struct ppz8_cache *cache;
 };
 
 void ppz8_init(struct ppz8 *ppz8, uint16_t srate, uint16_t mix_volume);
 void ppz8_mix(struct ppz8 *ppz8, int16_t *buf, unsigned samples);
+// add to int32 mix bus without clamping
+void ppz8_mix32(struct ppz8 *ppz8, int32_t *buf, unsigned samples);
+// the bank is replaced only if the whole file decodes
 bool ppz8_pvi_load(struct ppz8 *ppz8, uint8_t buf,
                    const uint8_t *pvidata, uint32_t pvidatalen,
                    int16_t *decodebuf);
 bool ppz8_pzi_load(struct ppz8 *ppz8, uint8_t bnum,
                    const uint8_t *pzidata, uint32_t pzidatalen,
                    int16_t *decodebuf);
+// decode into pcmbuf without touching any struct ppz8,
+// voices not in the file are left empty
+bool ppz8_pvi_decode(struct ppz8_pcmbuf *pcmbuf,
+                     const uint8_t *pvidata, uint32_t pvidatalen,
+                     int16_t *decodebuf);
+bool ppz8_pzi_decode(struct ppz8_pcmbuf *pcmbuf,
+                     const uint8_t *pzidata, uint32_t pzidatalen,
+                     int16_t *decodebuf);
+
+// sets a bank decoded earlier by ppz8_pvi_decode or ppz8_pzi_decode,
+// pcmbuf->data is shared, not copied
+void ppz8_set_pcmbuf(struct ppz8 *ppz8, uint8_t bnum,
+                     const struct ppz8_pcmbuf *pcmbuf);
 
 static inline uint32_t ppz8_pvi_decodebuf_samples(uint32_t pvidatalen) {
   if (pvidatalen < 0x210) return 0;
@@ -74,6 +158,12 @@ static inline uint32_t ppz8_pzi_decodebuf_samples(uint32_t pzidatalen) {
   return (pzidatalen - 0x920) * 2;
 }
 
+// memlen: in samples, used in whole blocks
+// up to PPZ8_CACHE_BLOCK * PPZ8_CACHE_BLOCKS
+void ppz8_cache_init(struct ppz8_cache *cache, int16_t *mem, size_t memlen);
+// call after ppz8_init, 0 disables the cache
+void ppz8_set_cache(struct ppz8 *ppz8, struct ppz8_cache *cache);
+
 unsigned ppz8_get_mask(const struct ppz8 *ppz8);
 void ppz8_set_mask(struct ppz8 *ppz8, unsigned mask);
 
@@ -81,6 +171,23 @@ static inline void ppz8_set_interpolation(struct ppz8 *ppz8, enum ppz8_interp in
   ppz8->interp = interp;
 }
 
+// 7 tap sinc, the 8th tap is 0
+extern const int16_t ppz8_sinctable[256][8];
+
+// sinc interpolated output for samples pointer positions
+// ptr, ptr+ptrdiff, ... (16.16 fixed point indexes into data)
+// data[(ptr>>16)-3] to data[(ptr>>16)+4] have to be readable for every position
+typedef void (*ppz8_sinc_calc_func_type)(const int16_t *data, uint64_t ptr,
+                                         uint64_t ptrdiff, int32_t *out,
+                                         unsigned samples);
+extern ppz8_sinc_calc_func_type ppz8_sinc_calc_func;
+void ppz8_sinc_calc_c(const int16_t *data, uint64_t ptr, uint64_t ptrdiff,
+                      int32_t *out, unsigned samples);
+void ppz8_sinc_calc_sse2(const int16_t *data, uint64_t ptr, uint64_t ptrdiff,
+                         int32_t *out, unsigned samples) __attribute__((hot, optimize(3)));
+void ppz8_sinc_calc_wasm(const int16_t *data, uint64_t ptr, uint64_t ptrdiff,
+                         int32_t *out, unsigned samples) __attribute__((hot, optimize(3)));
+
 struct ppz8_functbl {
   void (*channel_play)(struct ppz8 *ppz8, uint8_t channel, uint8_t voice);
   void (*channel_stop)(struct ppz8 *ppz8, uint8_t channel);
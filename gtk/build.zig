@@ -53,24 +53,34 @@ pub fn build(b: *std.Build) void {
         "libopna/opnafm.c",
         "libopna/opnassg.c",
         "libopna/opnassg-sinc-c.c",
+        "libopna/opnacpu.c",
+        "libopna/opnafm-soa-c.c",
         "libopna/opnatimer.c",
+        "libopna/opnaratecvt.c",
         "libopna/opna.c",
         "pacc/pacc-gl.c",
+        "soundout/aheadout.c",
         "soundout/soundout.c",
         "tonedata/tonedata.c",
     }) catch @panic("OOM");
     if (enable_neon) {
         mod.addCMacro("ENABLE_NEON", "");
         files.append(b.allocator, "libopna/opnassg-sinc-neon.s") catch @panic("OOM");
+        files.append(b.allocator, "libopna/opnafm-soa-neon.c") catch @panic("OOM");
     }
     if (enable_sse) {
         mod.addCMacro("ENABLE_SSE", "");
         files.append(b.allocator, "libopna/opnassg-sinc-sse2.c") catch @panic("OOM");
+        files.append(b.allocator, "libopna/opnafm-soa-sse2.c") catch @panic("OOM");
+        files.append(b.allocator, "fmdriver/ppz8-sinc-sse2.c") catch @panic("OOM");
+        files.append(b.allocator, "libopna/opnaratecvt-sse2.c") catch @panic("OOM");
+        // newer kernels are always built, opna_cpu_select picks them at runtime
+        mod.addCMacro("ENABLE_AVX2", "");
+        mod.addCMacro("ENABLE_AVX512", "");
     }
     if (jack) {
         mod.addCMacro("ENABLE_JACK", "");
         mod.linkSystemLibrary("jack", .{});
-        mod.linkSystemLibrary("soxr", .{});
         files.append(b.allocator, "soundout/jackout.c") catch @panic("OOM");
     }
     if (pulse) {
@@ -83,21 +93,39 @@ pub fn build(b: *std.Build) void {
         mod.linkSystemLibrary("alsa", .{});
         files.append(b.allocator, "soundout/alsaout.c") catch @panic("OOM");
     }
+    const cflags = [_][]const u8{
+        "-std=c11",
+        "-Wall",
+        "-Wextra",
+        "-Werror",
+        "-pedantic",
+        "-Wno-deprecated-declarations", // TODO: deprecated GTK API
+        "-Wno-unknown-attributes", // due to optimize attribute
+        "-Wno-unused-parameter", // TODO: in soundout.c
+        "-fno-sanitize=shift",
+    };
     mod.addCSourceFiles(.{
         .root = b.path(".."),
         .files = files.items,
-        .flags = &.{
-            "-std=c11",
-            "-Wall",
-            "-Wextra",
-            "-Werror",
-            "-pedantic",
-            "-Wno-deprecated-declarations", // TODO: deprecated GTK API
-            "-Wno-unknown-attributes", // due to optimize attribute
-            "-Wno-unused-parameter", // TODO: in soundout.c
-            "-fno-sanitize=shift",
-        },
+        .flags = &cflags,
     });
+    if (enable_sse) {
+        mod.addCSourceFiles(.{
+            .root = b.path(".."),
+            .files = &.{
+                "libopna/opnassg-sinc-avx2.c",
+                "libopna/opnafm-soa-avx2.c",
+            },
+            .flags = &(cflags ++ [_][]const u8{"-mavx2"}),
+        });
+        mod.addCSourceFiles(.{
+            .root = b.path(".."),
+            .files = &.{
+                "libopna/opnassg-sinc-avx512.c",
+            },
+            .flags = &(cflags ++ [_][]const u8{ "-mavx512f", "-mavx512bw" }),
+        });
+    }
 
     const exe = b.addExecutable(.{
         .name = "98fmplayer",
@@ -11,6 +11,8 @@
 #include "fmdriver/ppz8.h"
 #include "libopna/opna.h"
 #include "libopna/opnatimer.h"
+#include "libopna/opnaratecvt.h"
+#include "libopna/opnacpu.h"
 #include "pacc/pacc.h"
 #include "pacc/pacc-gl.h"
 #include "fmdsp/fmdsp-pacc.h"
@@ -25,6 +27,7 @@
 #include "fft/fft.h"
 
 #include "soundout.h"
+#include "aheadout.h"
 
 #include "fmplayer.xpm"
 #include "fmplayer32.xpm"
@@ -35,7 +38,10 @@ enum {
   SRATE = 55467,
 //  SRATE = 55555,
   PPZ8MIX = 0xa000,
-  AUDIOBUFLEN = 0,
+  // frames rendered ahead of the audio callback, --render-ahead
+  RENDER_AHEAD_FRAMES = 4096,
+  RENDER_AHEAD_MIN_FRAMES = 256,
+  RENDER_AHEAD_MAX_FRAMES = FFTDELAYMAX,
 };
 
 static struct {
@@ -47,6 +53,10 @@ static struct {
   GtkWidget *filechooser_widget;
   bool sound_paused;
   struct sound_state *ss;
+  int render_ahead_frames;
+  // &ratecvt_buf when the backend does not run at SRATE
+  struct opna_ratecvt *ratecvt;
+  struct opna_ratecvt ratecvt_buf;
   atomic_flag opna_flag;
   struct opna opna;
   struct opna_timer opna_timer;
@@ -67,6 +77,7 @@ static struct {
   struct pacc_ctx *pc;
   struct fmdsp_pacc *fp;
 } g = {
+  .render_ahead_frames = RENDER_AHEAD_FRAMES,
   .oscillo_should_update = true,
   .opna_flag = ATOMIC_FLAG_INIT,
   .at_fftdata_flag = ATOMIC_FLAG_INIT,
@@ -139,13 +150,16 @@ static void msgbox_err(const char *msg) {
   gtk_widget_destroy(d);
 }
 
-static void soundout_cb(void *userptr, int16_t *buf, unsigned frames) {
+static void soundout_cb(void *userptr, float *l, float *r, unsigned frames) {
   struct opna_timer *timer = (struct opna_timer *)userptr;
-  memset(buf, 0, sizeof(int16_t)*frames*2);
+  struct oscillodata *oscillo =
+    g.oscillo_should_update ? g.oscillodata_audiothread : 0;
   while (atomic_flag_test_and_set_explicit(&g.opna_flag, memory_order_acquire));
-  opna_timer_mix_oscillo(timer, buf, frames,
-                         g.oscillo_should_update ?
-                         g.oscillodata_audiothread : 0);
+  if (g.ratecvt) {
+    opna_ratecvt_mix_f32_oscillo(g.ratecvt, timer, l, r, frames, oscillo);
+  } else {
+    opna_timer_mix_f32_oscillo(timer, l, r, frames, oscillo);
+  }
   atomic_flag_clear_explicit(&g.opna_flag, memory_order_release);
   if (!atomic_flag_test_and_set_explicit(
       &toneview_g.flag, memory_order_acquire)) {
@@ -155,13 +169,15 @@ static void soundout_cb(void *userptr, int16_t *buf, unsigned frames) {
   if (g.oscillo_should_update) {
     if (!atomic_flag_test_and_set_explicit(
       &oscilloview_g.flag, memory_order_acquire)) {
-      memcpy(oscilloview_g.oscillodata, g.oscillodata_audiothread, sizeof(oscilloview_g.oscillodata));
+      for (int i = 0; i < LIBOPNA_OSCILLO_TRACK_COUNT; i++) {
+        oscillo_sync(&oscilloview_g.oscillodata[i], &g.oscillodata_audiothread[i]);
+      }
       atomic_flag_clear_explicit(&oscilloview_g.flag, memory_order_release);
     }
   }
   if (!atomic_flag_test_and_set_explicit(
     &g.at_fftdata_flag, memory_order_acquire)) {
-    fft_write(&g.at_fftdata, buf, frames);
+    fft_write_f32(&g.at_fftdata, l, r, frames);
     atomic_flag_clear_explicit(&g.at_fftdata_flag, memory_order_release);
   }
 }
@@ -183,11 +199,17 @@ static bool openfile(const char *uri) {
     goto err;
   }
   if (!g.ss) {
-    g.ss = sound_init("98FMPlayer", SRATE, soundout_cb, &g.opna_timer);
+    g.ss = aheadout_init("98FMPlayer", SRATE, OPNA_RATECVT_MIN_OUTRATE,
+                         soundout_cb, &g.opna_timer, g.render_ahead_frames);
     if (!g.ss) {
       msgbox_err("cannot open audio stream");
       goto err;
     }
+    if (g.ss->srate != SRATE) {
+      opna_ratecvt_init(&g.ratecvt_buf, g.ss->srate);
+      g.ratecvt = &g.ratecvt_buf;
+    }
+    g.fftdata.srate = g.ss->srate;
   } else if (!g.sound_paused) {
     g.ss->pause(g.ss, 1, 0);
   }
@@ -197,6 +219,7 @@ static bool openfile(const char *uri) {
   g.work = (struct fmdriver_work){0};
   memset(g.adpcm_ram, 0, sizeof(g.adpcm_ram));
   fmplayer_init_work_opna(&g.work, &g.ppz8, &g.opna, &g.opna_timer, g.adpcm_ram);
+  if (g.ratecvt) opna_ratecvt_reset(g.ratecvt);
   opna_set_mask(&g.opna, mask);
   config_update(0);
   char *disppath = g_filename_from_uri(uri, 0, 0);
@@ -316,6 +339,11 @@ static gboolean tick_cb(GtkWidget *w,
   (void)w;
   (void)frame_clock;
   (void)p;
+  // show what is heard now, not what was rendered last
+  unsigned delay = g.ss ? aheadout_buffered(g.ss) : 0;
+  g.fftdata.delay = delay;
+  // the oscilloscope is fed at SRATE
+  oscilloview_g.delay = g.ss ? (uint64_t)delay * SRATE / g.ss->srate : 0;
   gtk_widget_queue_draw(g.fmdsp_widget);
   return G_SOURCE_CONTINUE;
 }
@@ -507,15 +535,25 @@ static void drag_data_recv_cb(
 }
 
 int main(int argc, char **argv) {
-#ifdef ENABLE_NEON
-  opna_ssg_sinc_calc_func = opna_ssg_sinc_calc_neon;
-#endif
-#ifdef ENABLE_SSE
-  opna_ssg_sinc_calc_func = opna_ssg_sinc_calc_sse2;
-#endif
+  opna_cpu_select();
   fft_init_table();
   fmplayer_font_rom_load(&g.font98);
-  gtk_init(&argc, &argv);
+  static GOptionEntry options[] = {
+    { "render-ahead", 'a', 0, G_OPTION_ARG_INT, &g.render_ahead_frames,
+      "Render FRAMES ahead of the audio output (256 to 8192, default 4096)", "FRAMES" },
+    { 0 },
+  };
+  GError *error = 0;
+  if (!gtk_init_with_args(&argc, &argv, 0, options, 0, &error)) {
+    g_printerr("%s\n", error ? error->message : "cannot initialize GTK");
+    return 1;
+  }
+  if (g.render_ahead_frames < RENDER_AHEAD_MIN_FRAMES) {
+    g.render_ahead_frames = RENDER_AHEAD_MIN_FRAMES;
+  }
+  if (g.render_ahead_frames > RENDER_AHEAD_MAX_FRAMES) {
+    g.render_ahead_frames = RENDER_AHEAD_MAX_FRAMES;
+  }
   {
     GList *iconlist = 0;
     iconlist = g_list_append(iconlist, gdk_pixbuf_new_from_xpm_data(fmplayer_xpm_16));
@@ -11,11 +11,12 @@ struct oscilloview oscilloview_g = {
 
 enum {
   VIEW_SAMPLES = 1024,
+  VIEW_TRACKS = 9,
 };
 
 static struct {
   GtkWidget *win;
-  struct oscillodata oscillodata[LIBOPNA_OSCILLO_TRACK_COUNT];
+  int16_t viewdata[VIEW_TRACKS][VIEW_SAMPLES];
   GLuint program;
   GLuint vs, fs;
   GLuint vao;
@@ -124,9 +125,10 @@ static gboolean on_render(GtkGLArea *area,
   (void)ptr;
   if (!atomic_flag_test_and_set_explicit(
     &oscilloview_g.flag, memory_order_acquire)) {
-    memcpy(g.oscillodata,
-           oscilloview_g.oscillodata,
-           sizeof(oscilloview_g.oscillodata));
+    for (int i = 0; i < VIEW_TRACKS; i++) {
+      oscillo_window_delay(g.viewdata[i], &oscilloview_g.oscillodata[i], VIEW_SAMPLES,
+                           oscilloview_g.delay);
+    }
     atomic_flag_clear_explicit(&oscilloview_g.flag, memory_order_release);
   }
   glEnableVertexAttribArray(0);
@@ -135,10 +137,8 @@ static gboolean on_render(GtkGLArea *area,
 
   for (int x = 0; x < 3; x++) {
     for (int y = 0; y < 3; y++) {
-      int start = OSCILLO_SAMPLE_COUNT - VIEW_SAMPLES;
-      start -= (g.oscillodata[x*3+y].offset >> OSCILLO_OFFSET_SHIFT);
       glBindBuffer(GL_ARRAY_BUFFER, g.vbo_data);
-      glBufferData(GL_ARRAY_BUFFER, 2*VIEW_SAMPLES, &g.oscillodata[x*3+y].buf[start], GL_STREAM_DRAW);
+      glBufferData(GL_ARRAY_BUFFER, 2*VIEW_SAMPLES, g.viewdata[x*3+y], GL_STREAM_DRAW);
       glUniform1f(g.uni_xpos, (x - 1) * (2.0f/3.0f));
       glUniform1f(g.uni_ypos, (y - 1) * (-2.0f/3.0f));
       glDrawArrays(GL_LINE_STRIP, 0, 1024);
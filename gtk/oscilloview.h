@@ -9,6 +9,8 @@
 extern struct oscilloview {
   atomic_flag flag;
   struct oscillodata oscillodata[LIBOPNA_OSCILLO_TRACK_COUNT];
+  // samples rendered but not heard yet, set by the main window
+  unsigned delay;
 } oscilloview_g;
 
 void show_oscilloview(void);
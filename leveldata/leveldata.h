@@ -3,30 +3,35 @@
 
 #include <stdatomic.h>
 
+// written by the audio thread, read by the UI thread
+// neither side waits for the other:
+// the reader marks the level as read with a single fetch_or,
+// the writer keeps the maximum until the level has been read
+// not an enum, ISO C enumerators are limited to int
+#define LEVELDATA_READ (1u << 31)
+
 struct leveldata {
-  atomic_flag flag;
-  unsigned level;
-  bool read;
+  // level | LEVELDATA_READ if read
+  atomic_uint level;
 };
 
 static inline unsigned leveldata_read(struct leveldata *data) {
-  while (atomic_flag_test_and_set_explicit(&data->flag, memory_order_acquire));
-  unsigned level = data->level;
-  data->read = true;
-  atomic_flag_clear_explicit(&data->flag, memory_order_release);
-  return level;
+  return atomic_fetch_or_explicit(&data->level, LEVELDATA_READ,
+                                  memory_order_relaxed) & ~LEVELDATA_READ;
 }
 
 static inline void leveldata_update(struct leveldata *data, unsigned level) {
-  while (atomic_flag_test_and_set_explicit(&data->flag, memory_order_acquire));
-  if (data->read || (level > data->level)) data->level = level;
-  data->read = false;
-  atomic_flag_clear_explicit(&data->flag, memory_order_release);
+  level &= ~LEVELDATA_READ;
+  unsigned old = atomic_load_explicit(&data->level, memory_order_relaxed);
+  // only retried when the reader marked the level in between
+  while (((old & LEVELDATA_READ) || level > old) &&
+         !atomic_compare_exchange_weak_explicit(
+           &data->level, &old, level,
+           memory_order_relaxed, memory_order_relaxed));
 }
 
 static inline void leveldata_init(struct leveldata *data) {
-  *data = (struct leveldata) {0};
-  atomic_flag_clear_explicit(&data->flag, memory_order_relaxed);
+  atomic_init(&data->level, 0);
 }
 
 #endif // MYON_LEVELDATA_H_INCLUDED
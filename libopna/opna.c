@@ -2,7 +2,19 @@
 #ifdef LIBOPNA_ENABLE_OSCILLO
 #include "oscillo/oscillo.h"
 #endif
-#include <string.h>
+
+#ifdef LIBOPNA_ENABLE_PROFILE
+static uint64_t opna_profile_begin(const struct opna *opna) {
+  return opna->profile ? opna->profile->clock() : 0;
+}
+
+static void opna_profile_end(struct opna *opna, int block, uint64_t begin) {
+  if (opna->profile) opna->profile->time[block] += opna->profile->clock() - begin;
+}
+#else
+#define opna_profile_begin(opna) 0
+#define opna_profile_end(opna, block, begin) ((void)(begin))
+#endif
 
 void opna_reset(struct opna *opna) {
   opna_fm_reset(&opna->fm);
@@ -33,14 +45,7 @@ void opna_mix(struct opna *opna, int16_t *buf, unsigned samples) {
 
 void opna_mix_oscillo(struct opna *opna, int16_t *buf, unsigned samples, struct oscillodata *oscillo) {
 #ifdef LIBOPNA_ENABLE_OSCILLO
-  if (oscillo) {
-    for (int i = 0; i < LIBOPNA_OSCILLO_TRACK_COUNT; i++) {
-      memmove(&oscillo[i].buf[0],
-              &oscillo[i].buf[samples],
-              (OSCILLO_SAMPLE_COUNT - samples)*sizeof(oscillo[i].buf[0]));
-    }
-  }
-  unsigned offset = OSCILLO_SAMPLE_COUNT - samples;
+  unsigned offset = oscillo ? oscillo[0].pos : 0;
   struct oscillodata *oscillofm = oscillo ? &oscillo[0] : 0;
   struct oscillodata *oscillossg = oscillo ? &oscillo[6] : 0;
 #else
@@ -48,11 +53,63 @@ void opna_mix_oscillo(struct opna *opna, int16_t *buf, unsigned samples, struct
   struct oscillodata *oscillofm = 0, *oscillossg = 0;
   unsigned offset = 0;
 #endif
+  uint64_t t = opna_profile_begin(opna);
   opna_fm_mix(&opna->fm, buf, samples, oscillofm, offset);
+  opna_profile_end(opna, OPNA_PROFILE_FM, t);
+  t = opna_profile_begin(opna);
   opna_ssg_mix_55466(&opna->ssg, &opna->resampler, buf, samples,
                      oscillossg, offset);
+  opna_profile_end(opna, OPNA_PROFILE_SSG, t);
+  t = opna_profile_begin(opna);
   opna_drum_mix(&opna->drum, buf, samples);
+  opna_profile_end(opna, OPNA_PROFILE_DRUM, t);
+  t = opna_profile_begin(opna);
   opna_adpcm_mix(&opna->adpcm, buf, samples);
+  opna_profile_end(opna, OPNA_PROFILE_ADPCM, t);
+#ifdef LIBOPNA_ENABLE_OSCILLO
+  if (oscillo) {
+    for (int i = 0; i < LIBOPNA_OSCILLO_TRACK_COUNT; i++) {
+      oscillo[i].pos = offset + samples;
+    }
+  }
+#endif
+  opna->generated_frames += samples;
+}
+
+void opna_mix32(struct opna *opna, int32_t *buf, unsigned samples) {
+  opna_mix32_oscillo(opna, buf, samples, 0);
+}
+
+void opna_mix32_oscillo(struct opna *opna, int32_t *buf, unsigned samples, struct oscillodata *oscillo) {
+#ifdef LIBOPNA_ENABLE_OSCILLO
+  unsigned offset = oscillo ? oscillo[0].pos : 0;
+  struct oscillodata *oscillofm = oscillo ? &oscillo[0] : 0;
+  struct oscillodata *oscillossg = oscillo ? &oscillo[6] : 0;
+#else
+  (void)oscillo;
+  struct oscillodata *oscillofm = 0, *oscillossg = 0;
+  unsigned offset = 0;
+#endif
+  uint64_t t = opna_profile_begin(opna);
+  opna_fm_mix32(&opna->fm, buf, samples, oscillofm, offset);
+  opna_profile_end(opna, OPNA_PROFILE_FM, t);
+  t = opna_profile_begin(opna);
+  opna_ssg_mix32_55466(&opna->ssg, &opna->resampler, buf, samples,
+                       oscillossg, offset);
+  opna_profile_end(opna, OPNA_PROFILE_SSG, t);
+  t = opna_profile_begin(opna);
+  opna_drum_mix32(&opna->drum, buf, samples);
+  opna_profile_end(opna, OPNA_PROFILE_DRUM, t);
+  t = opna_profile_begin(opna);
+  opna_adpcm_mix32(&opna->adpcm, buf, samples);
+  opna_profile_end(opna, OPNA_PROFILE_ADPCM, t);
+#ifdef LIBOPNA_ENABLE_OSCILLO
+  if (oscillo) {
+    for (int i = 0; i < LIBOPNA_OSCILLO_TRACK_COUNT; i++) {
+      oscillo[i].pos = offset + samples;
+    }
+  }
+#endif
   opna->generated_frames += samples;
 }
 
@@ -34,6 +34,23 @@ enum {
   LIBOPNA_OSCILLO_TRACK_COUNT = 11
 };
 
+#ifdef LIBOPNA_ENABLE_PROFILE
+// per-block time spent in opna_mix, for benchmarking
+enum {
+  OPNA_PROFILE_FM,
+  OPNA_PROFILE_SSG,
+  OPNA_PROFILE_DRUM,
+  OPNA_PROFILE_ADPCM,
+  OPNA_PROFILE_CNT
+};
+
+struct opna_profile {
+  // monotonic clock, any unit
+  uint64_t (*clock)(void);
+  uint64_t time[OPNA_PROFILE_CNT];
+};
+#endif
+
 struct opna {
   struct opna_fm fm;
   struct opna_ssg ssg;
@@ -42,6 +59,10 @@ struct opna {
   struct opna_ssg_resampler resampler;
   unsigned mask;
   uint64_t generated_frames;
+#ifdef LIBOPNA_ENABLE_PROFILE
+  // set by user, not touched by opna_reset, can be NULL
+  struct opna_profile *profile;
+#endif
 };
 
 void opna_reset(struct opna *opna);
@@ -50,6 +71,9 @@ unsigned opna_readreg(const struct opna *opna, unsigned reg);
 void opna_mix(struct opna *opna, int16_t *buf, unsigned samples);
 struct oscillodata;
 void opna_mix_oscillo(struct opna *opna, int16_t *buf, unsigned samples, struct oscillodata *oscillo);
+// add to int32 mix bus (see opnamix.h) without clamping
+void opna_mix32(struct opna *opna, int32_t *buf, unsigned samples);
+void opna_mix32_oscillo(struct opna *opna, int32_t *buf, unsigned samples, struct oscillodata *oscillo);
 unsigned opna_get_mask(const struct opna *opna);
 void opna_set_mask(struct opna *opna, unsigned mask);
 
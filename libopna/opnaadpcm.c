@@ -1,4 +1,5 @@
 #include "opnaadpcm.h"
+#include "opnamix.h"
 
 enum {
   C1_START = 0x80,
@@ -184,6 +185,23 @@ void opna_adpcm_writereg(struct opna_adpcm *adpcm, unsigned reg, unsigned val) {
 }
 
 void opna_adpcm_mix(struct opna_adpcm *adpcm, int16_t *buf, unsigned samples) {
+  if (!adpcm->ram || !(adpcm->control1 & C1_START)) {
+    opna_adpcm_mix32(adpcm, 0, samples);
+    return;
+  }
+  int32_t acc[OPNA_MIX32_CHUNK*2];
+  while (samples) {
+    unsigned chunk = samples < OPNA_MIX32_CHUNK ? samples : OPNA_MIX32_CHUNK;
+    opna_mix32_load(acc, buf, chunk);
+    opna_adpcm_mix32(adpcm, acc, chunk);
+    opna_mix32_store(buf, acc, chunk);
+    if (!(adpcm->control1 & C1_START)) return;
+    buf += chunk*2;
+    samples -= chunk;
+  }
+}
+
+void opna_adpcm_mix32(struct opna_adpcm *adpcm, int32_t *buf, unsigned samples) {
   unsigned level = 0;
   if (!adpcm->ram || !(adpcm->control1 & C1_START)) {
 #ifdef LIBOPNA_ENABLE_LEVELDATA
@@ -199,16 +217,8 @@ void opna_adpcm_mix(struct opna_adpcm *adpcm, int16_t *buf, unsigned samples) {
       if (((unsigned)clevel) > level) level = clevel;
     }
     if (!adpcm->masked) {
-      int32_t lo = buf[i*2+0];
-      int32_t ro = buf[i*2+1];
-      if (adpcm->control2 & C2_L) lo += (adpcm->out>>1);
-      if (adpcm->control2 & C2_R) ro += (adpcm->out>>1);
-      if (lo < INT16_MIN) lo = INT16_MIN;
-      if (lo > INT16_MAX) lo = INT16_MAX;
-      if (ro < INT16_MIN) ro = INT16_MIN;
-      if (ro > INT16_MAX) ro = INT16_MAX;
-      buf[i*2+0] = lo;
-      buf[i*2+1] = ro;
+      if (adpcm->control2 & C2_L) buf[i*2+0] += (adpcm->out>>1);
+      if (adpcm->control2 & C2_R) buf[i*2+1] += (adpcm->out>>1);
     }
     if (!(adpcm->control1 & C1_START)) return;
   }
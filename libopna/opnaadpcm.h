@@ -34,6 +34,8 @@ struct opna_adpcm {
 
 void opna_adpcm_reset(struct opna_adpcm *adpcm);
 void opna_adpcm_mix(struct opna_adpcm *adpcm, int16_t *buf, unsigned samples);
+// add to int32 mix bus without clamping
+void opna_adpcm_mix32(struct opna_adpcm *adpcm, int32_t *buf, unsigned samples);
 void opna_adpcm_writereg(struct opna_adpcm *adpcm, unsigned reg, unsigned val);
 
 enum {
@@ -0,0 +1,92 @@
+#include "libopna/opnacpu.h"
+#include "libopna/opnafm.h"
+
+#if defined(ENABLE_SSE) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#define OPNA_CPU_X86
+#endif
+
+const struct opna_cpu_ssg_sinc_kernel opna_cpu_ssg_sinc_kernels[] = {
+  { "c", 0, opna_ssg_sinc_calc_c, true },
+#ifdef ENABLE_NEON
+  { "neon", OPNA_CPU_NEON, opna_ssg_sinc_calc_neon, true },
+#endif
+#ifdef ENABLE_SSE
+  // SSE2 is baseline on x86-64, where compilers turn the C kernel into
+  // the same pmaddwd loop, fully unrolled
+  { "sse2", OPNA_CPU_SSE2, opna_ssg_sinc_calc_sse2, false },
+#endif
+#ifdef ENABLE_AVX2
+  { "avx2", OPNA_CPU_AVX2, opna_ssg_sinc_calc_avx2, true },
+#endif
+#ifdef ENABLE_AVX512
+  { "avx512", OPNA_CPU_AVX512BW, opna_ssg_sinc_calc_avx512, true },
+#endif
+#ifdef ENABLE_WASM_SIMD
+  { "simd128", OPNA_CPU_WASM_SIMD128, opna_ssg_sinc_calc_wasm, true },
+#endif
+};
+
+const unsigned opna_cpu_ssg_sinc_kernel_cnt =
+  sizeof(opna_cpu_ssg_sinc_kernels) / sizeof(opna_cpu_ssg_sinc_kernels[0]);
+
+#ifdef OPNA_CPU_X86
+static uint32_t xgetbv0(void) {
+  uint32_t eax, edx;
+  __asm__ volatile ("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+  return eax;
+}
+#endif
+
+unsigned opna_cpu_features(void) {
+  unsigned features = 0;
+#ifdef ENABLE_NEON
+  features |= OPNA_CPU_NEON;
+#endif
+#ifdef ENABLE_WASM_SIMD
+  features |= OPNA_CPU_WASM_SIMD128;
+#endif
+#ifdef OPNA_CPU_X86
+  unsigned eax, ebx, ecx, edx;
+  if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return features;
+  if (edx & bit_SSE2) features |= OPNA_CPU_SSE2;
+  // the OS has to save the YMM/ZMM registers too
+  if (!(ecx & bit_OSXSAVE) || !(ecx & bit_AVX)) return features;
+  uint32_t xcr0 = xgetbv0();
+  if ((xcr0 & 0x06) != 0x06) return features;
+  if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) return features;
+  if (ebx & bit_AVX2) features |= OPNA_CPU_AVX2;
+  if ((xcr0 & 0xe6) == 0xe6 && (ebx & bit_AVX512F) && (ebx & bit_AVX512BW)) {
+    features |= OPNA_CPU_AVX512BW;
+  }
+#endif
+  return features;
+}
+
+const char *opna_cpu_select(void) {
+  unsigned features = opna_cpu_features();
+  const struct opna_cpu_ssg_sinc_kernel *ssg = &opna_cpu_ssg_sinc_kernels[0];
+  for (unsigned i = 1; i < opna_cpu_ssg_sinc_kernel_cnt; i++) {
+    const struct opna_cpu_ssg_sinc_kernel *k = &opna_cpu_ssg_sinc_kernels[i];
+    if (k->select && (k->features & features) == k->features) ssg = k;
+  }
+  opna_ssg_sinc_calc_func = ssg->func;
+
+  // only the AVX2 kernel is faster than the scalar engine,
+  // SSE2 is on par and C is slower
+  opna_fm_soa_calc_func = opna_fm_soa_calc_c;
+  opna_fm_soa_preferred = false;
+#ifdef ENABLE_SSE
+  if (features & OPNA_CPU_SSE2) opna_fm_soa_calc_func = opna_fm_soa_calc_sse2;
+#endif
+#ifdef ENABLE_AVX2
+  if (features & OPNA_CPU_AVX2) {
+    opna_fm_soa_calc_func = opna_fm_soa_calc_avx2;
+    opna_fm_soa_preferred = true;
+  }
+#endif
+#ifdef ENABLE_NEON
+  if (features & OPNA_CPU_NEON) opna_fm_soa_calc_func = opna_fm_soa_calc_neon;
+#endif
+  return ssg->name;
+}
@@ -0,0 +1,46 @@
+#ifndef LIBOPNA_OPNACPU_H_INCLUDED
+#define LIBOPNA_OPNACPU_H_INCLUDED
+
+#include "libopna/opnassg.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// kernels are compiled in with ENABLE_NEON, ENABLE_SSE, ENABLE_AVX2,
+// ENABLE_AVX512 and ENABLE_WASM_SIMD, and only used when the running CPU
+// (and OS) supports them
+enum {
+  OPNA_CPU_NEON = 1u<<0,
+  OPNA_CPU_SSE2 = 1u<<1,
+  OPNA_CPU_AVX2 = 1u<<2,
+  OPNA_CPU_AVX512BW = 1u<<3,
+  OPNA_CPU_WASM_SIMD128 = 1u<<4,
+};
+
+struct opna_cpu_ssg_sinc_kernel {
+  const char *name;
+  // required OPNA_CPU_* bits
+  unsigned features;
+  opna_ssg_sinc_calc_func_type func;
+  // false if the C kernel is as fast, only timed by 98fmbench -k
+  bool select;
+};
+
+// all compiled-in SSG resampler kernels, slowest first
+extern const struct opna_cpu_ssg_sinc_kernel opna_cpu_ssg_sinc_kernels[];
+extern const unsigned opna_cpu_ssg_sinc_kernel_cnt;
+
+// OPNA_CPU_* bits usable on the running CPU
+unsigned opna_cpu_features(void);
+
+// set opna_ssg_sinc_calc_func and opna_fm_soa_calc_func to the fastest
+// kernels usable on the running CPU, and opna_fm_soa_preferred
+// returns the name of the selected SSG kernel
+const char *opna_cpu_select(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LIBOPNA_OPNACPU_H_INCLUDED
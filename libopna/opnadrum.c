@@ -1,4 +1,5 @@
 #include "opnadrum.h"
+#include "opnamix.h"
 
 static const uint16_t steps[49] = {
   16,  17,   19,   21,   23,   25,   28,
@@ -84,10 +85,22 @@ void opna_drum_set_rom(struct opna_drum *drum, void *romptr) {
 }
 
 void opna_drum_mix(struct opna_drum *drum, int16_t *buf, int samples) {
+  int32_t acc[OPNA_MIX32_CHUNK*2];
+  while (samples > 0) {
+    int chunk = samples < OPNA_MIX32_CHUNK ? samples : OPNA_MIX32_CHUNK;
+    opna_mix32_load(acc, buf, chunk);
+    opna_drum_mix32(drum, acc, chunk);
+    opna_mix32_store(buf, acc, chunk);
+    buf += chunk*2;
+    samples -= chunk;
+  }
+}
+
+void opna_drum_mix32(struct opna_drum *drum, int32_t *buf, int samples) {
   unsigned levels[6] = {0};
   for (int i = 0; i < samples; i++) {
-    int32_t lo = buf[i*2+0];
-    int32_t ro = buf[i*2+1];
+    int32_t lo = 0;
+    int32_t ro = 0;
     for (int d = 0; d < 6; d++) {
       if (drum->drums[d].playing && drum->drums[d].data) {
         int co = drum->drums[d].data[drum->drums[d].index];
@@ -109,12 +122,8 @@ void opna_drum_mix(struct opna_drum *drum, int16_t *buf, int samples) {
         }
       }
     }
-    if (lo < INT16_MIN) lo = INT16_MIN;
-    if (lo > INT16_MAX) lo = INT16_MAX;
-    if (ro < INT16_MIN) ro = INT16_MIN;
-    if (ro > INT16_MAX) ro = INT16_MAX;
-    buf[i*2+0] = lo;
-    buf[i*2+1] = ro;
+    buf[i*2+0] += lo;
+    buf[i*2+1] += ro;
   }
 #ifdef LIBOPNA_ENABLE_LEVELDATA
   for (int d = 0; d < 6; d++) {
@@ -54,6 +54,8 @@ void opna_drum_reset(struct opna_drum *drum);
 void opna_drum_set_rom(struct opna_drum *drum, void *rom);
 
 void opna_drum_mix(struct opna_drum *drum, int16_t *buf, int samples);
+// add to int32 mix bus without clamping
+void opna_drum_mix32(struct opna_drum *drum, int32_t *buf, int samples);
 
 void opna_drum_writereg(struct opna_drum *drum, unsigned reg, unsigned val);
 
@@ -0,0 +1,68 @@
+#include "libopna/opnafm.h"
+#include <immintrin.h>
+
+#define LD(a) _mm256_load_si256((const __m256i *)(a))
+#define ST(a, v) _mm256_store_si256((__m256i *)(a), (v))
+#define R(r) LD(soa->route[OPNA_FM_SOA_##r])
+#define AND(a, r) _mm256_and_si256((a), R(r))
+#define ADD(a, b) _mm256_add_epi32((a), (b))
+
+static inline __m256i slotout(__m256i phase, __m256i att, __m256i mod) {
+  __m256i pind = ADD(_mm256_srli_epi32(phase, 10), _mm256_srai_epi32(mod, 1));
+  __m256i minus = _mm256_srai_epi32(_mm256_slli_epi32(pind, 22), 31);
+  __m256i reverse = _mm256_srai_epi32(_mm256_slli_epi32(pind, 23), 31);
+  pind = _mm256_and_si256(_mm256_xor_si256(pind, reverse), _mm256_set1_epi32(0xff));
+  __m256i logout = ADD(_mm256_i32gather_epi32(opna_fm_soa_logsintable, pind, 4), att);
+  __m256i shifter = _mm256_min_epi32(_mm256_srai_epi32(logout, 8), _mm256_set1_epi32(13));
+  __m256i out = _mm256_i32gather_epi32(
+      opna_fm_soa_exptable, _mm256_and_si256(logout, _mm256_set1_epi32(0xff)), 4);
+  out = _mm256_srlv_epi32(_mm256_slli_epi32(out, 2), shifter);
+  return _mm256_sub_epi32(_mm256_xor_si256(out, minus), minus);
+}
+
+static inline __m256i sext(__m256i v, int bits) {
+  return _mm256_srai_epi32(_mm256_slli_epi32(v, 32-bits), 32-bits);
+}
+
+static inline __m256i sra1(__m256i v) {
+  return _mm256_srai_epi32(v, 1);
+}
+
+void opna_fm_soa_calc_avx2(struct opna_fm_soa *soa) {
+  __m256i o0 = LD(soa->prevout[0]);
+  __m256i o1 = LD(soa->prevout[1]);
+  __m256i o2 = LD(soa->prevout[2]);
+  __m256i o3 = LD(soa->prevout[3]);
+  __m256i pam = LD(soa->alg_mem);
+  __m256i fb = sext(ADD(LD(soa->fbmem), o0), 16);
+  ST(soa->fbmem, o0);
+  fb = _mm256_and_si256(_mm256_srav_epi32(fb, LD(soa->fbshift)), LD(soa->fbmask));
+
+  __m256i n0 = slotout(LD(soa->phase[0]), LD(soa->att[0]), fb);
+  __m256i n1 = slotout(LD(soa->phase[1]), LD(soa->att[1]),
+                       ADD(AND(n0, R1_N0), AND(o0, R1_O0)));
+  __m256i n2 = slotout(LD(soa->phase[2]), LD(soa->att[2]),
+                       ADD(ADD(AND(o1, R2_O1), AND(pam, R2_PAM)), AND(o0, R2_O0)));
+  __m256i n3 = slotout(LD(soa->phase[3]), LD(soa->att[3]),
+                       ADD(ADD(AND(o2, R3_O2), AND(o0, R3_O0)),
+                           ADD(AND(pam, R3_PAM), AND(n2, R3_N2))));
+  __m256i nm = ADD(ADD(AND(n0, M_N0), AND(n1, M_N1)),
+                   ADD(ADD(AND(o1, M_O1), AND(o2, M_O2)), AND(n2, M_N2)));
+  nm = ADD(AND(nm, M_AND), AND(pam, M_KEEP));
+
+  __m256i both = ADD(ADD(AND(sra1(n3), Q_N3), AND(sra1(o3), Q_O3)), AND(sra1(n0), Q_N0));
+  __m256i d0 = ADD(ADD(both, AND(sra1(n1), Q_N1)),
+                   ADD(AND(sra1(o2), Q_O2), AND(sra1(nm), Q_NM)));
+  __m256i d1 = ADD(both, ADD(AND(sra1(o1), Q_O1), AND(sra1(pam), Q_PAM)));
+
+  ST(soa->prevout[0], n0);
+  ST(soa->prevout[1], n1);
+  ST(soa->prevout[2], n2);
+  ST(soa->prevout[3], n3);
+  ST(soa->alg_mem, nm);
+  ST(soa->out[0], sext(d0, 15));
+  ST(soa->out[1], sext(d1, 15));
+  for (int s = 0; s < 4; s++) {
+    ST(soa->phase[s], ADD(LD(soa->phase[s]), LD(soa->phase_inc[s])));
+  }
+}
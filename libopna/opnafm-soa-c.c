@@ -0,0 +1,62 @@
+#include "libopna/opnafm.h"
+
+#define R(r) (soa->route[OPNA_FM_SOA_##r][c])
+
+static inline int32_t soa_slotout(uint32_t phase, int32_t att, int32_t mod) {
+  uint32_t pind = (phase >> 10) + (mod >> 1);
+  bool minus = pind & (1<<9);
+  if (pind & (1<<8)) pind = ~pind;
+  pind &= (1<<8)-1;
+  int32_t logout = opna_fm_soa_logsintable[pind] + att;
+  int32_t shifter = logout >> 8;
+  if (shifter > 13) shifter = 13;
+  int32_t out = (opna_fm_soa_exptable[logout & 0xff] << 2) >> shifter;
+  return minus ? -out : out;
+}
+
+// 16bit wraparound as in opna_fm_chanout
+static inline int32_t sext(int32_t v, int bits) {
+  return (int32_t)((uint32_t)v << (32-bits)) >> (32-bits);
+}
+
+void opna_fm_soa_calc_c(struct opna_fm_soa *soa) {
+  for (int c = 0; c < OPNA_FM_SOA_LANES; c++) {
+    int32_t o0 = soa->prevout[0][c];
+    int32_t o1 = soa->prevout[1][c];
+    int32_t o2 = soa->prevout[2][c];
+    int32_t o3 = soa->prevout[3][c];
+    int32_t pam = soa->alg_mem[c];
+    int32_t fb = sext(soa->fbmem[c] + o0, 16);
+    soa->fbmem[c] = o0;
+
+    int32_t n0 = soa_slotout(soa->phase[0][c], soa->att[0][c],
+                             (fb >> soa->fbshift[c]) & soa->fbmask[c]);
+    int32_t n1 = soa_slotout(soa->phase[1][c], soa->att[1][c],
+                             (n0 & R(R1_N0)) + (o0 & R(R1_O0)));
+    int32_t n2 = soa_slotout(soa->phase[2][c], soa->att[2][c],
+                             (o1 & R(R2_O1)) + (pam & R(R2_PAM)) + (o0 & R(R2_O0)));
+    int32_t n3 = soa_slotout(soa->phase[3][c], soa->att[3][c],
+                             (o2 & R(R3_O2)) + (o0 & R(R3_O0)) +
+                             (pam & R(R3_PAM)) + (n2 & R(R3_N2)));
+    int32_t nm = (pam & R(M_KEEP)) +
+                 (((n0 & R(M_N0)) + (n1 & R(M_N1)) + (o1 & R(M_O1)) +
+                   (o2 & R(M_O2)) + (n2 & R(M_N2))) & R(M_AND));
+    int32_t both = ((n3 >> 1) & R(Q_N3)) + ((o3 >> 1) & R(Q_O3)) +
+                   ((n0 >> 1) & R(Q_N0));
+    int32_t d0 = both + ((n1 >> 1) & R(Q_N1)) + ((o2 >> 1) & R(Q_O2)) +
+                 ((nm >> 1) & R(Q_NM));
+    int32_t d1 = both + ((o1 >> 1) & R(Q_O1)) + ((pam >> 1) & R(Q_PAM));
+
+    soa->prevout[0][c] = n0;
+    soa->prevout[1][c] = n1;
+    soa->prevout[2][c] = n2;
+    soa->prevout[3][c] = n3;
+    soa->alg_mem[c] = nm;
+    // 15bit wraparound for alg 7, no-op otherwise
+    soa->out[0][c] = sext(d0, 15);
+    soa->out[1][c] = sext(d1, 15);
+    for (int s = 0; s < 4; s++) {
+      soa->phase[s][c] += soa->phase_inc[s][c];
+    }
+  }
+}
@@ -0,0 +1,90 @@
+#include "libopna/opnafm.h"
+#include <arm_neon.h>
+
+#define LD(a) vld1q_s32((const int32_t *)&(a)[h*4])
+#define ST(a, v) vst1q_s32((int32_t *)&(a)[h*4], (v))
+#define R(r) LD(soa->route[OPNA_FM_SOA_##r])
+
+static inline int32x4_t lookup(const int32_t *table, int32x4_t index) {
+  int32_t ind[4] __attribute__((aligned(16)));
+  vst1q_s32(ind, index);
+  int32_t val[4] __attribute__((aligned(16))) = {
+    table[ind[0]], table[ind[1]], table[ind[2]], table[ind[3]]
+  };
+  return vld1q_s32(val);
+}
+
+static inline int32x4_t slotout(int32x4_t phase, int32x4_t att, int32x4_t mod) {
+  int32x4_t pind = vaddq_s32(
+      vreinterpretq_s32_u32(vshrq_n_u32(vreinterpretq_u32_s32(phase), 10)),
+      vshrq_n_s32(mod, 1));
+  int32x4_t minus = vshrq_n_s32(vshlq_n_s32(pind, 22), 31);
+  int32x4_t reverse = vshrq_n_s32(vshlq_n_s32(pind, 23), 31);
+  pind = vandq_s32(veorq_s32(pind, reverse), vdupq_n_s32(0xff));
+  int32x4_t logout = vaddq_s32(lookup(opna_fm_soa_logsintable, pind), att);
+  int32x4_t shifter = vminq_s32(vshrq_n_s32(logout, 8), vdupq_n_s32(13));
+  int32x4_t out = vshlq_n_s32(
+      lookup(opna_fm_soa_exptable, vandq_s32(logout, vdupq_n_s32(0xff))), 2);
+  // vshl with a negative count shifts right
+  out = vshlq_s32(out, vnegq_s32(shifter));
+  return vsubq_s32(veorq_s32(out, minus), minus);
+}
+
+static inline int32x4_t sext(int32x4_t v, int bits) {
+  return vshlq_s32(vshlq_s32(v, vdupq_n_s32(32-bits)), vdupq_n_s32(bits-32));
+}
+
+static inline int32x4_t sra1(int32x4_t v) {
+  return vshrq_n_s32(v, 1);
+}
+
+void opna_fm_soa_calc_neon(struct opna_fm_soa *soa) {
+  for (int h = 0; h < OPNA_FM_SOA_LANES/4; h++) {
+    int32x4_t o0 = LD(soa->prevout[0]);
+    int32x4_t o1 = LD(soa->prevout[1]);
+    int32x4_t o2 = LD(soa->prevout[2]);
+    int32x4_t o3 = LD(soa->prevout[3]);
+    int32x4_t pam = LD(soa->alg_mem);
+    int32x4_t fb = sext(vaddq_s32(LD(soa->fbmem), o0), 16);
+    ST(soa->fbmem, o0);
+    fb = vandq_s32(vshlq_s32(fb, vnegq_s32(LD(soa->fbshift))), LD(soa->fbmask));
+
+    int32x4_t n0 = slotout(LD(soa->phase[0]), LD(soa->att[0]), fb);
+    int32x4_t n1 = slotout(LD(soa->phase[1]), LD(soa->att[1]),
+        vaddq_s32(vandq_s32(n0, R(R1_N0)), vandq_s32(o0, R(R1_O0))));
+    int32x4_t n2 = slotout(LD(soa->phase[2]), LD(soa->att[2]),
+        vaddq_s32(vaddq_s32(vandq_s32(o1, R(R2_O1)),
+                            vandq_s32(pam, R(R2_PAM))),
+                  vandq_s32(o0, R(R2_O0))));
+    int32x4_t n3 = slotout(LD(soa->phase[3]), LD(soa->att[3]),
+        vaddq_s32(vaddq_s32(vandq_s32(o2, R(R3_O2)),
+                            vandq_s32(o0, R(R3_O0))),
+                  vaddq_s32(vandq_s32(pam, R(R3_PAM)),
+                            vandq_s32(n2, R(R3_N2)))));
+    int32x4_t nm = vaddq_s32(vandq_s32(n0, R(M_N0)), vandq_s32(n1, R(M_N1)));
+    nm = vaddq_s32(nm, vandq_s32(o1, R(M_O1)));
+    nm = vaddq_s32(nm, vandq_s32(o2, R(M_O2)));
+    nm = vaddq_s32(nm, vandq_s32(n2, R(M_N2)));
+    nm = vaddq_s32(vandq_s32(nm, R(M_AND)), vandq_s32(pam, R(M_KEEP)));
+
+    int32x4_t both = vaddq_s32(vandq_s32(sra1(n3), R(Q_N3)),
+                               vandq_s32(sra1(o3), R(Q_O3)));
+    both = vaddq_s32(both, vandq_s32(sra1(n0), R(Q_N0)));
+    int32x4_t d0 = vaddq_s32(both, vandq_s32(sra1(n1), R(Q_N1)));
+    d0 = vaddq_s32(d0, vandq_s32(sra1(o2), R(Q_O2)));
+    d0 = vaddq_s32(d0, vandq_s32(sra1(nm), R(Q_NM)));
+    int32x4_t d1 = vaddq_s32(both, vandq_s32(sra1(o1), R(Q_O1)));
+    d1 = vaddq_s32(d1, vandq_s32(sra1(pam), R(Q_PAM)));
+
+    ST(soa->prevout[0], n0);
+    ST(soa->prevout[1], n1);
+    ST(soa->prevout[2], n2);
+    ST(soa->prevout[3], n3);
+    ST(soa->alg_mem, nm);
+    ST(soa->out[0], sext(d0, 15));
+    ST(soa->out[1], sext(d1, 15));
+    for (int s = 0; s < 4; s++) {
+      ST(soa->phase[s], vaddq_s32(LD(soa->phase[s]), LD(soa->phase_inc[s])));
+    }
+  }
+}
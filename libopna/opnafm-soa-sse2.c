@@ -0,0 +1,97 @@
+#include "libopna/opnafm.h"
+#include <emmintrin.h>
+
+#define LD(a) _mm_load_si128((const __m128i *)&(a)[h*4])
+#define ST(a, v) _mm_store_si128((__m128i *)&(a)[h*4], (v))
+#define R(r) LD(soa->route[OPNA_FM_SOA_##r])
+
+// 2^(e) for 0 <= e < 32, via float exponent
+static inline __m128i pow2(__m128i e) {
+  e = _mm_add_epi32(e, _mm_set1_epi32(127));
+  return _mm_cvttps_epi32(_mm_castsi128_ps(_mm_slli_epi32(e, 23)));
+}
+
+static inline __m128i lookup(const int32_t *table, __m128i index) {
+  int32_t ind[4] __attribute__((aligned(16)));
+  _mm_store_si128((__m128i *)ind, index);
+  return _mm_setr_epi32(table[ind[0]], table[ind[1]], table[ind[2]], table[ind[3]]);
+}
+
+static inline __m128i slotout(__m128i phase, __m128i att, __m128i mod) {
+  __m128i pind = _mm_add_epi32(_mm_srli_epi32(phase, 10), _mm_srai_epi32(mod, 1));
+  __m128i minus = _mm_srai_epi32(_mm_slli_epi32(pind, 22), 31);
+  __m128i reverse = _mm_srai_epi32(_mm_slli_epi32(pind, 23), 31);
+  pind = _mm_and_si128(_mm_xor_si128(pind, reverse), _mm_set1_epi32(0xff));
+  __m128i logout = _mm_add_epi32(lookup(opna_fm_soa_logsintable, pind), att);
+  __m128i shifter = _mm_srai_epi32(logout, 8);
+  __m128i over = _mm_cmpgt_epi32(shifter, _mm_set1_epi32(13));
+  shifter = _mm_or_si128(_mm_andnot_si128(over, shifter),
+                         _mm_and_si128(over, _mm_set1_epi32(13)));
+  __m128i out = _mm_slli_epi32(
+      lookup(opna_fm_soa_exptable, _mm_and_si128(logout, _mm_set1_epi32(0xff))), 2);
+  // out >> shifter == (out * 2^(13-shifter)) >> 13, both fit in 16bit
+  out = _mm_madd_epi16(out, pow2(_mm_sub_epi32(_mm_set1_epi32(13), shifter)));
+  out = _mm_srli_epi32(out, 13);
+  return _mm_sub_epi32(_mm_xor_si128(out, minus), minus);
+}
+
+static inline __m128i sext(__m128i v, int bits) {
+  return _mm_srai_epi32(_mm_slli_epi32(v, 32-bits), 32-bits);
+}
+
+static inline __m128i sra1(__m128i v) {
+  return _mm_srai_epi32(v, 1);
+}
+
+void opna_fm_soa_calc_sse2(struct opna_fm_soa *soa) {
+  for (int h = 0; h < OPNA_FM_SOA_LANES/4; h++) {
+    __m128i o0 = LD(soa->prevout[0]);
+    __m128i o1 = LD(soa->prevout[1]);
+    __m128i o2 = LD(soa->prevout[2]);
+    __m128i o3 = LD(soa->prevout[3]);
+    __m128i pam = LD(soa->alg_mem);
+    __m128i fb = sext(_mm_add_epi32(LD(soa->fbmem), o0), 16);
+    ST(soa->fbmem, o0);
+    // fb >> fbshift == (fb * 2^(16-fbshift)) >> 16 with 16bit signed multiply
+    fb = _mm_mulhi_epi16(fb, pow2(_mm_sub_epi32(_mm_set1_epi32(16), LD(soa->fbshift))));
+    fb = _mm_and_si128(sext(fb, 16), LD(soa->fbmask));
+
+    __m128i n0 = slotout(LD(soa->phase[0]), LD(soa->att[0]), fb);
+    __m128i n1 = slotout(LD(soa->phase[1]), LD(soa->att[1]),
+        _mm_add_epi32(_mm_and_si128(n0, R(R1_N0)), _mm_and_si128(o0, R(R1_O0))));
+    __m128i n2 = slotout(LD(soa->phase[2]), LD(soa->att[2]),
+        _mm_add_epi32(_mm_add_epi32(_mm_and_si128(o1, R(R2_O1)),
+                                    _mm_and_si128(pam, R(R2_PAM))),
+                      _mm_and_si128(o0, R(R2_O0))));
+    __m128i n3 = slotout(LD(soa->phase[3]), LD(soa->att[3]),
+        _mm_add_epi32(_mm_add_epi32(_mm_and_si128(o2, R(R3_O2)),
+                                    _mm_and_si128(o0, R(R3_O0))),
+                      _mm_add_epi32(_mm_and_si128(pam, R(R3_PAM)),
+                                    _mm_and_si128(n2, R(R3_N2)))));
+    __m128i nm = _mm_add_epi32(_mm_and_si128(n0, R(M_N0)), _mm_and_si128(n1, R(M_N1)));
+    nm = _mm_add_epi32(nm, _mm_and_si128(o1, R(M_O1)));
+    nm = _mm_add_epi32(nm, _mm_and_si128(o2, R(M_O2)));
+    nm = _mm_add_epi32(nm, _mm_and_si128(n2, R(M_N2)));
+    nm = _mm_add_epi32(_mm_and_si128(nm, R(M_AND)), _mm_and_si128(pam, R(M_KEEP)));
+
+    __m128i both = _mm_add_epi32(_mm_and_si128(sra1(n3), R(Q_N3)),
+                                 _mm_and_si128(sra1(o3), R(Q_O3)));
+    both = _mm_add_epi32(both, _mm_and_si128(sra1(n0), R(Q_N0)));
+    __m128i d0 = _mm_add_epi32(both, _mm_and_si128(sra1(n1), R(Q_N1)));
+    d0 = _mm_add_epi32(d0, _mm_and_si128(sra1(o2), R(Q_O2)));
+    d0 = _mm_add_epi32(d0, _mm_and_si128(sra1(nm), R(Q_NM)));
+    __m128i d1 = _mm_add_epi32(both, _mm_and_si128(sra1(o1), R(Q_O1)));
+    d1 = _mm_add_epi32(d1, _mm_and_si128(sra1(pam), R(Q_PAM)));
+
+    ST(soa->prevout[0], n0);
+    ST(soa->prevout[1], n1);
+    ST(soa->prevout[2], n2);
+    ST(soa->prevout[3], n3);
+    ST(soa->alg_mem, nm);
+    ST(soa->out[0], sext(d0, 15));
+    ST(soa->out[1], sext(d1, 15));
+    for (int s = 0; s < 4; s++) {
+      ST(soa->phase[s], _mm_add_epi32(LD(soa->phase[s]), LD(soa->phase_inc[s])));
+    }
+  }
+}
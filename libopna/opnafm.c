@@ -1,10 +1,21 @@
 #include "opnafm.h"
+#include "opnamix.h"
 #ifdef LIBOPNA_ENABLE_OSCILLO
 #include "oscillo/oscillo.h"
 #endif
 
 #include "opnatables.h"
 
+const int32_t opna_fm_soa_logsintable[LOGSINTABLELEN] = {
+  LOGSINTABLE_DATA
+};
+const int32_t opna_fm_soa_exptable[EXPTABLELEN] = {
+  EXPTABLE_DATA
+};
+
+opna_fm_soa_calc_func_type opna_fm_soa_calc_func = opna_fm_soa_calc_c;
+bool opna_fm_soa_preferred = false;
+
 #if 1
 #define LIBOPNA_DEBUG(...)
 #else
@@ -117,7 +128,7 @@ static unsigned blkfnum2keycode(unsigned blk, unsigned fnum) {
 
 #undef F
 
-static void opna_fm_slot_phase(struct opna_fm_slot *slot, unsigned freq) {
+static unsigned opna_fm_slot_phase_inc(const struct opna_fm_slot *slot, unsigned freq) {
 // TODO: detune
 //  freq += slot->dt;
   unsigned det = dettable[slot->det & 0x3][slot->keycode];
@@ -126,7 +137,11 @@ static void opna_fm_slot_phase(struct opna_fm_slot *slot, unsigned freq) {
   freq &= (1U<<17)-1;
   int mul = slot->mul << 1;
   if (!mul) mul = 1;
-  slot->phase += ((freq * mul)>>1);
+  return (freq * mul)>>1;
+}
+
+static void opna_fm_slot_phase(struct opna_fm_slot *slot, unsigned freq) {
+  slot->phase += opna_fm_slot_phase_inc(slot, freq);
 }
 
 void opna_fm_chan_phase(struct opna_fm_channel *chan) {
@@ -627,8 +642,249 @@ static int gcd(int a, int b) {
 }
 #endif
 
+// slot stays silent and does not change except for phase and env_count
+static bool opna_fm_slot_idle(const struct opna_fm_slot *slot, bool hires_env) {
+  if (slot->keyon_ext) return false;
+  if (slot->env_state != ENV_OFF && slot->env_state != ENV_SUSTAIN) return false;
+  if (slot->env != LIBOPNA_FM_ENV_MAX) return false;
+  if (slot->env_hires != (hires_env ? ENV_MAX_HIRES : (LIBOPNA_FM_ENV_MAX << 2))) return false;
+  return !slot->prevout;
+}
+
+// bitmask of channels which would output 0 for every sample
+// until the next register write
+static unsigned opna_fm_idle_mask(const struct opna_fm *fm) {
+  unsigned idle = 0;
+  for (int c = 0; c < 6; c++) {
+    const struct opna_fm_channel *chan = &fm->channel[c];
+    if (chan->fbmem || chan->alg_mem) continue;
+    bool slot_idle = true;
+    for (int s = 0; s < 4; s++) {
+      slot_idle = slot_idle && opna_fm_slot_idle(&chan->slot[s], fm->hires_env);
+    }
+    if (slot_idle) idle |= (1u<<c);
+  }
+  return idle;
+}
+
+static unsigned opna_fm_slot_freq(const struct opna_fm *fm, int c, int s) {
+  if (c == 2 && fm->ch3.mode != CH3_MODE_NORMAL && s != 3) {
+    return blkfnum2freq(fm->ch3.blk[s], fm->ch3.fnum[s]);
+  }
+  return blkfnum2freq(fm->channel[c].blk, fm->channel[c].fnum);
+}
+
+// advance idle channels by samples without calculating output
+// env_ticks: number of envelope updates in that period
+static void opna_fm_idle_advance(struct opna_fm *fm, unsigned idle,
+                                 unsigned samples, unsigned env_ticks) {
+  for (int c = 0; c < 6; c++) {
+    if (!(idle & (1u<<c))) continue;
+    for (int s = 0; s < 4; s++) {
+      struct opna_fm_slot *slot = &fm->channel[c].slot[s];
+      slot->phase += opna_fm_slot_phase_inc(slot, opna_fm_slot_freq(fm, c, s)) * samples;
+      slot->env_count += env_ticks;
+    }
+    fm->idle_skipped[c] += samples;
+  }
+}
+
+// first half of the envelope update (once per 3 samples), before output
+// channels in the idle mask are skipped
+static void opna_fm_env_keyon(struct opna_fm *fm, unsigned idle) {
+  for (int c = 0; c < 6; c++) {
+    if (idle & (1u<<c)) continue;
+    for (int s = 0; s < 4; s++) {
+      if (fm->channel[c].slot[s].keyon_ext) {
+        opna_fm_slot_key(&fm->channel[c], s, true);
+        opna_fm_slot_env(&fm->channel[c].slot[s], fm->hires_env);
+      }
+      //opna_fm_slot_env(&fm->channel[c].slot[s]);
+    }
+  }
+  //LIBOPNA_DEBUG("e %04d\n", fm->channel[0].slot[3].env);
+}
+
+// second half of the envelope update, after output
+static void opna_fm_env_step(struct opna_fm *fm, unsigned idle) {
+  for (int c = 0; c < 6; c++) {
+    if (idle & (1u<<c)) continue;
+    for (int s = 0; s < 4; s++) {
+      if (fm->channel[c].slot[s].keyon_ext) {
+        fm->channel[c].slot[s].keyon_ext = false;
+      } else {
+        opna_fm_slot_env(&fm->channel[c].slot[s], fm->hires_env);
+      }
+      //opna_fm_slot_env(&fm->channel[c].slot[s]);
+    }
+  }
+}
+
+// routing masks for opna_fm_soa, 1: -1, 0: 0
+// except for M_AND, 1: ~1, 0: -1
+static const uint8_t soa_algroute[8][OPNA_FM_SOA_ROUTE_CNT] = {
+// R1    R2       R3          M                     Q
+// N0 O0 O1 PA O0 O2 O0 PA N2 KP N0 N1 O1 O2 N2 AN  N3 O3 N0 N1 O2 NM O1 PA
+  { 1, 0, 1, 0, 0, 1, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0},
+  { 0, 0, 0, 1, 0, 1, 0, 0, 0, 0, 1, 1, 0, 0, 0, 1, 1, 0, 0, 0, 0, 0, 0, 0},
+  { 0, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0},
+  { 1, 0, 0, 0, 0, 1, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0},
+  { 0, 1, 0, 0, 0, 0, 0, 0, 1, 1, 0, 0, 0, 0, 0, 0, 0, 1, 0, 1, 0, 0, 1, 0},
+  { 0, 1, 0, 0, 1, 0, 1, 0, 0, 0, 0, 0, 0, 1, 0, 1, 0, 1, 0, 1, 1, 0, 1, 1},
+  { 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 1, 0, 1, 0, 1, 1, 0, 1, 1},
+  { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 1, 1, 1, 0, 1, 0, 0, 1, 0, 1},
+};
+
+static void opna_fm_soa_load_att(struct opna_fm_soa *soa, const struct opna_fm *fm) {
+  for (int c = 0; c < 6; c++) {
+    for (int s = 0; s < 4; s++) {
+      const struct opna_fm_slot *slot = &fm->channel[c].slot[s];
+      soa->att[s][c] = (slot->env << 2) + (slot->tl << 5);
+    }
+  }
+}
+
+static void opna_fm_soa_load(struct opna_fm_soa *soa, const struct opna_fm *fm) {
+  *soa = (struct opna_fm_soa){0};
+  for (int c = 0; c < 6; c++) {
+    const struct opna_fm_channel *chan = &fm->channel[c];
+    for (int s = 0; s < 4; s++) {
+      const struct opna_fm_slot *slot = &chan->slot[s];
+      soa->phase[s][c] = slot->phase;
+      soa->phase_inc[s][c] = opna_fm_slot_phase_inc(slot, opna_fm_slot_freq(fm, c, s));
+      soa->prevout[s][c] = slot->prevout;
+    }
+    soa->fbmem[c] = (int16_t)chan->fbmem;
+    soa->fbshift[c] = 9 - chan->fb;
+    soa->fbmask[c] = chan->fb ? -1 : 0;
+    soa->alg_mem[c] = (int16_t)chan->alg_mem;
+    for (int r = 0; r < OPNA_FM_SOA_ROUTE_CNT; r++) {
+      bool on = soa_algroute[chan->alg][r];
+      if (r == OPNA_FM_SOA_M_AND) {
+        soa->route[r][c] = on ? ~1 : -1;
+      } else {
+        soa->route[r][c] = on ? -1 : 0;
+      }
+    }
+  }
+  opna_fm_soa_load_att(soa, fm);
+}
+
+// lanes of channels in the idle mask are not written back,
+// opna_fm_idle_advance updates them instead
+static void opna_fm_soa_store(const struct opna_fm_soa *soa, struct opna_fm *fm,
+                              unsigned idle) {
+  for (int c = 0; c < 6; c++) {
+    if (idle & (1u<<c)) continue;
+    struct opna_fm_channel *chan = &fm->channel[c];
+    for (int s = 0; s < 4; s++) {
+      chan->slot[s].phase = soa->phase[s][c];
+      chan->slot[s].prevout = soa->prevout[s][c];
+    }
+    chan->fbmem = soa->fbmem[c];
+    chan->alg_mem = soa->alg_mem[c];
+  }
+}
+
+// idle channels are still calculated in their lanes, but their output
+// is masked and their envelopes are left alone
+// returns the number of envelope updates for opna_fm_idle_advance
+static unsigned opna_fm_mix32_soa(struct opna_fm *fm, int32_t *buf, unsigned samples,
+                                  struct oscillodata *oscillo, unsigned offset,
+                                  unsigned *level, unsigned idle) {
+#ifndef LIBOPNA_ENABLE_OSCILLO
+  (void)oscillo;
+  (void)offset;
+#endif
+  struct opna_fm_soa soa;
+  opna_fm_soa_load(&soa, fm);
+  unsigned env_ticks = 0;
+  int32_t lmask[6], rmask[6];
+  for (int c = 0; c < 6; c++) {
+    bool masked = (fm->mask & (1<<c)) || (idle & (1u<<c));
+    lmask[c] = (!masked && fm->lselect[c]) ? -1 : 0;
+    rmask[c] = (!masked && fm->rselect[c]) ? -1 : 0;
+  }
+  for (unsigned i = 0; i < samples; i++) {
+    if (!fm->env_div3) {
+      env_ticks++;
+      // key on resets phase and prevout
+      for (int c = 0; c < 6; c++) {
+        for (int s = 0; s < 4; s++) {
+          struct opna_fm_slot *slot = &fm->channel[c].slot[s];
+          if (slot->keyon_ext) {
+            slot->phase = soa.phase[s][c];
+            slot->prevout = soa.prevout[s][c];
+          }
+        }
+      }
+      opna_fm_env_keyon(fm, idle);
+      for (int c = 0; c < 6; c++) {
+        for (int s = 0; s < 4; s++) {
+          const struct opna_fm_slot *slot = &fm->channel[c].slot[s];
+          if (slot->keyon_ext) {
+            soa.phase[s][c] = slot->phase;
+            soa.prevout[s][c] = slot->prevout;
+          }
+        }
+      }
+      opna_fm_soa_load_att(&soa, fm);
+    }
+
+    opna_fm_soa_calc_func(&soa);
+
+    int32_t lo = 0;
+    int32_t ro = 0;
+    for (int c = 0; c < 6; c++) {
+      if (idle & (1u<<c)) {
+#ifdef LIBOPNA_ENABLE_OSCILLO
+        if (oscillo) oscillo[c].buf[(offset+i) & OSCILLO_SAMPLE_MASK] = 0;
+#endif
+        continue;
+      }
+      int32_t o0 = soa.out[0][c];
+      int32_t o1 = soa.out[1][c];
+      unsigned nlevel[2];
+      nlevel[0] = o0 > 0 ? o0 : -o0;
+      nlevel[1] = o1 > 0 ? o1 : -o1;
+      if (nlevel[1] > nlevel[0]) nlevel[0] = nlevel[1];
+      if (nlevel[0] > level[c]) level[c] = nlevel[0];
+#ifdef LIBOPNA_ENABLE_OSCILLO
+      if (oscillo) oscillo[c].buf[(offset+i) & OSCILLO_SAMPLE_MASK] = o0 + o1;
+#endif
+      lo += o1 & lmask[c];
+      ro += o0 & rmask[c];
+    }
+    buf[i*2+0] += lo;
+    buf[i*2+1] += ro;
+
+    if (!fm->env_div3) {
+      opna_fm_env_step(fm, idle);
+      opna_fm_soa_load_att(&soa, fm);
+      fm->env_div3 = 3;
+    }
+    fm->env_div3--;
+  }
+  opna_fm_soa_store(&soa, fm, idle);
+  return env_ticks;
+}
+
 void opna_fm_mix(struct opna_fm *fm, int16_t *buf, unsigned samples,
                  struct oscillodata *oscillo, unsigned offset) {
+  int32_t acc[OPNA_MIX32_CHUNK*2];
+  while (samples) {
+    unsigned chunk = samples < OPNA_MIX32_CHUNK ? samples : OPNA_MIX32_CHUNK;
+    opna_mix32_load(acc, buf, chunk);
+    opna_fm_mix32(fm, acc, chunk, oscillo, offset);
+    opna_mix32_store(buf, acc, chunk);
+    buf += chunk*2;
+    offset += chunk;
+    samples -= chunk;
+  }
+}
+
+void opna_fm_mix32(struct opna_fm *fm, int32_t *buf, unsigned samples,
+                   struct oscillodata *oscillo, unsigned offset) {
 #ifdef LIBOPNA_ENABLE_OSCILLO
   if (oscillo) {
     for (unsigned c = 0; c < 6; c++) {
@@ -643,6 +899,7 @@ void opna_fm_mix(struct opna_fm *fm, int16_t *buf, unsigned samples,
       freq /= 2;
       unsigned period = 0;
       if (freq) period = (1u<<(20+OSCILLO_OFFSET_SHIFT)) / freq;
+      oscillo[c].period = period;
       if (period) {
         oscillo[c].offset += (samples << OSCILLO_OFFSET_SHIFT);
         oscillo[c].offset %= period;
@@ -656,70 +913,72 @@ void opna_fm_mix(struct opna_fm *fm, int16_t *buf, unsigned samples,
   (void)offset;
 #endif
   unsigned level[6] = {0};
-  for (unsigned i = 0; i < samples; i++) {
-    if (!fm->env_div3) {
-      for (int c = 0; c < 6; c++) {
-        for (int s = 0; s < 4; s++) {
-          if (fm->channel[c].slot[s].keyon_ext) {
-            opna_fm_slot_key(&fm->channel[c], s, true);
-            opna_fm_slot_env(&fm->channel[c].slot[s], fm->hires_env);
-          }
-          //opna_fm_slot_env(&fm->channel[c].slot[s]);
-        }
-      }
-      //LIBOPNA_DEBUG("e %04d\n", fm->channel[0].slot[3].env);
-    }
-    
-    int32_t lo = buf[i*2+0];
-    int32_t ro = buf[i*2+1];
-
-    for (int c = 0; c < 6; c++) {
-      struct opna_fm_frame o = opna_fm_chanout(&fm->channel[c], fm->hires_sin, fm->hires_env);
-      unsigned nlevel[2];
-      nlevel[0] = o.data[0] > 0 ? o.data[0] : -o.data[0];
-      nlevel[1] = o.data[1] > 0 ? o.data[1] : -o.data[1];
-      if (nlevel[1] > nlevel[0]) nlevel[0] = nlevel[1];
-      if (nlevel[0] > level[c]) level[c] = nlevel[0];
+  // idle channels only need phase and env_count updated, which is done
+  // at once after the loop
+  unsigned idle = opna_fm_idle_mask(fm);
+  unsigned env_ticks = 0;
+  if (idle == 0x3f) {
+    for (unsigned i = 0; i < samples; i++) {
 #ifdef LIBOPNA_ENABLE_OSCILLO
-      if (oscillo) oscillo[c].buf[offset+i] = o.data[0] + o.data[1];
+      if (oscillo) {
+        for (int c = 0; c < 6; c++) oscillo[c].buf[(offset+i) & OSCILLO_SAMPLE_MASK] = 0;
+      }
 #endif
-      // TODO: CSM
-      if (c == 2 && fm->ch3.mode != CH3_MODE_NORMAL) {
-        opna_fm_chan_phase_se(&fm->channel[c], fm);
-      } else {
-        opna_fm_chan_phase(&fm->channel[c]);
+      if (!fm->env_div3) {
+        env_ticks++;
+        fm->env_div3 = 3;
       }
-      if (fm->mask & (1<<c)) continue;
-      if (fm->lselect[c]) lo += o.data[1];
-      if (fm->rselect[c]) ro += o.data[0];
+      fm->env_div3--;
     }
+  } else if (fm->soa && !fm->hires_sin && !fm->hires_env) {
+    env_ticks = opna_fm_mix32_soa(fm, buf, samples, oscillo, offset, level, idle);
+  } else {
+    for (unsigned i = 0; i < samples; i++) {
+      if (!fm->env_div3) {
+        env_ticks++;
+        opna_fm_env_keyon(fm, idle);
+      }
+
+      int32_t lo = 0;
+      int32_t ro = 0;
 
-    if (lo < INT16_MIN) lo = INT16_MIN;
-    if (lo > INT16_MAX) lo = INT16_MAX;
-    if (ro < INT16_MIN) ro = INT16_MIN;
-    if (ro > INT16_MAX) ro = INT16_MAX;
-    buf[i*2+0] = lo;
-    buf[i*2+1] = ro;
-    if (lo == 1 || lo == 3 || lo == 5) {
-      //if (fm->channel[0].slot[3].env == 0511) {
-        //LIBOPNA_DEBUG("l:%6d %4d %4d\n", lo, fm->channel[0].slot[3].phase >> 10, fm->channel[0].slot[3].env);
-      //}
-    }
-    if (!fm->env_div3) {
       for (int c = 0; c < 6; c++) {
-        for (int s = 0; s < 4; s++) {
-          if (fm->channel[c].slot[s].keyon_ext) {
-            fm->channel[c].slot[s].keyon_ext = false;
-          } else {
-            opna_fm_slot_env(&fm->channel[c].slot[s], fm->hires_env);
-          }
-          //opna_fm_slot_env(&fm->channel[c].slot[s]);
+        if (idle & (1u<<c)) {
+#ifdef LIBOPNA_ENABLE_OSCILLO
+          if (oscillo) oscillo[c].buf[(offset+i) & OSCILLO_SAMPLE_MASK] = 0;
+#endif
+          continue;
         }
+        struct opna_fm_frame o = opna_fm_chanout(&fm->channel[c], fm->hires_sin, fm->hires_env);
+        unsigned nlevel[2];
+        nlevel[0] = o.data[0] > 0 ? o.data[0] : -o.data[0];
+        nlevel[1] = o.data[1] > 0 ? o.data[1] : -o.data[1];
+        if (nlevel[1] > nlevel[0]) nlevel[0] = nlevel[1];
+        if (nlevel[0] > level[c]) level[c] = nlevel[0];
+#ifdef LIBOPNA_ENABLE_OSCILLO
+        if (oscillo) oscillo[c].buf[(offset+i) & OSCILLO_SAMPLE_MASK] = o.data[0] + o.data[1];
+#endif
+        // TODO: CSM
+        if (c == 2 && fm->ch3.mode != CH3_MODE_NORMAL) {
+          opna_fm_chan_phase_se(&fm->channel[c], fm);
+        } else {
+          opna_fm_chan_phase(&fm->channel[c]);
+        }
+        if (fm->mask & (1<<c)) continue;
+        if (fm->lselect[c]) lo += o.data[1];
+        if (fm->rselect[c]) ro += o.data[0];
       }
-      fm->env_div3 = 3;
+
+      buf[i*2+0] += lo;
+      buf[i*2+1] += ro;
+      if (!fm->env_div3) {
+        opna_fm_env_step(fm, idle);
+        fm->env_div3 = 3;
+      }
+      fm->env_div3--;
     }
-    fm->env_div3--;
   }
+  opna_fm_idle_advance(fm, idle, samples, env_ticks);
 #ifdef LIBOPNA_ENABLE_LEVELDATA
   for (int c = 0; c < 6; c++) {
     leveldata_update(&fm->channel[c].leveldata, level[c]);
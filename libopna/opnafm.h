@@ -76,6 +76,67 @@ struct opna_fm_channel {
 #endif
 };
 
+// structure-of-arrays working set for all 24 operators
+// lane = channel, 6 used, padded to 8 lanes for SIMD
+// only used when !hires_sin && !hires_env
+enum {
+  OPNA_FM_SOA_LANES = 8,
+};
+
+// per-lane operator routing masks, derived from alg
+// see opna_fm_chanout for the scalar equivalent
+enum {
+  // slot 1 modulation: new slot 0 out, old slot 0 out
+  OPNA_FM_SOA_R1_N0,
+  OPNA_FM_SOA_R1_O0,
+  // slot 2 modulation: old slot 1, alg_mem, old slot 0
+  OPNA_FM_SOA_R2_O1,
+  OPNA_FM_SOA_R2_PAM,
+  OPNA_FM_SOA_R2_O0,
+  // slot 3 modulation: old slot 2, old slot 0, alg_mem, new slot 2
+  OPNA_FM_SOA_R3_O2,
+  OPNA_FM_SOA_R3_O0,
+  OPNA_FM_SOA_R3_PAM,
+  OPNA_FM_SOA_R3_N2,
+  // new alg_mem: keep, sum of selected outputs, then and with M_AND
+  OPNA_FM_SOA_M_KEEP,
+  OPNA_FM_SOA_M_N0,
+  OPNA_FM_SOA_M_N1,
+  OPNA_FM_SOA_M_O1,
+  OPNA_FM_SOA_M_O2,
+  OPNA_FM_SOA_M_N2,
+  OPNA_FM_SOA_M_AND,
+  // output terms (each >> 1)
+  // both: N3, O3, N0; data[0]: N1, O2, NM (new alg_mem); data[1]: O1, PAM
+  OPNA_FM_SOA_Q_N3,
+  OPNA_FM_SOA_Q_O3,
+  OPNA_FM_SOA_Q_N0,
+  OPNA_FM_SOA_Q_N1,
+  OPNA_FM_SOA_Q_O2,
+  OPNA_FM_SOA_Q_NM,
+  OPNA_FM_SOA_Q_O1,
+  OPNA_FM_SOA_Q_PAM,
+  OPNA_FM_SOA_ROUTE_CNT
+};
+
+struct opna_fm_soa {
+  // [slot][channel], every row aligned for 256bit loads
+  uint32_t phase[4][OPNA_FM_SOA_LANES] __attribute__((aligned(32)));
+  uint32_t phase_inc[4][OPNA_FM_SOA_LANES];
+  // (env << 2) + (tl << 5)
+  int32_t att[4][OPNA_FM_SOA_LANES];
+  int32_t prevout[4][OPNA_FM_SOA_LANES];
+  int32_t fbmem[OPNA_FM_SOA_LANES];
+  // 9 - fb
+  int32_t fbshift[OPNA_FM_SOA_LANES];
+  // -1 when fb != 0
+  int32_t fbmask[OPNA_FM_SOA_LANES];
+  int32_t alg_mem[OPNA_FM_SOA_LANES];
+  int32_t route[OPNA_FM_SOA_ROUTE_CNT][OPNA_FM_SOA_LANES];
+  // channel output of the last calculated sample, same as opna_fm_frame
+  int32_t out[2][OPNA_FM_SOA_LANES];
+};
+
 struct opna_fm {
   struct opna_fm_channel channel[6];
 
@@ -102,11 +163,18 @@ struct opna_fm {
   
   bool hires_sin;
   bool hires_env;
+  // use structure-of-arrays operator engine (opna_fm_soa_calc_func)
+  bool soa;
+  // channel-samples skipped because all slots were silent
+  // (see opna_fm_idle_mask), for statistics only
+  uint64_t idle_skipped[6];
 };
 
 void opna_fm_reset(struct opna_fm *fm);
 struct oscillodata;
 void opna_fm_mix(struct opna_fm *fm, int16_t *buf, unsigned samples, struct oscillodata *oscillo, unsigned offset);
+// add output to int32 mix bus without clamping
+void opna_fm_mix32(struct opna_fm *fm, int32_t *buf, unsigned samples, struct oscillodata *oscillo, unsigned offset);
 void opna_fm_writereg(struct opna_fm *fm, unsigned reg, unsigned val);
 
 //
@@ -134,6 +202,21 @@ void opna_fm_slot_set_ks(struct opna_fm_slot *slot, unsigned ks);
 void opna_fm_slot_set_mul(struct opna_fm_slot *slot, unsigned mul);
 void opna_fm_slot_set_det(struct opna_fm_slot *slot, unsigned det);
 
+// calculate one sample for all lanes, then advance phase
+typedef void (*opna_fm_soa_calc_func_type)(struct opna_fm_soa *soa);
+extern opna_fm_soa_calc_func_type opna_fm_soa_calc_func;
+// whether opna_fm_soa_calc_func is faster than the scalar engine,
+// set by opna_cpu_select
+extern bool opna_fm_soa_preferred;
+void opna_fm_soa_calc_c(struct opna_fm_soa *soa) __attribute__((hot, optimize(3)));
+void opna_fm_soa_calc_sse2(struct opna_fm_soa *soa) __attribute__((hot, optimize(3)));
+void opna_fm_soa_calc_avx2(struct opna_fm_soa *soa) __attribute__((hot, optimize(3)));
+void opna_fm_soa_calc_neon(struct opna_fm_soa *soa) __attribute__((hot, optimize(3)));
+
+// int32 copies of logsintable/exptable for SIMD gathers
+extern const int32_t opna_fm_soa_logsintable[];
+extern const int32_t opna_fm_soa_exptable[];
+
 static inline void opna_fm_set_hires_sin(struct opna_fm *fm, bool hires) {
   fm->hires_sin = hires;
 }
@@ -142,6 +225,10 @@ static inline void opna_fm_set_hires_env(struct opna_fm *fm, bool hires) {
   fm->hires_env = hires;
 }
 
+static inline void opna_fm_set_soa(struct opna_fm *fm, bool soa) {
+  fm->soa = soa;
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,79 @@
+#ifndef LIBOPNA_OPNAMIX_H_INCLUDED
+#define LIBOPNA_OPNAMIX_H_INCLUDED
+
+#include <stdint.h>
+#ifdef ENABLE_WASM_SIMD
+#include <wasm_simd128.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// int32 mix bus:
+// every block adds its output to the same stereo int32 buffer
+// and the result is clamped to int16 only once at the end
+enum {
+  OPNA_MIX32_CHUNK = 256,
+};
+
+// sign-extend int16 stereo frames into the mix bus
+static inline void opna_mix32_load(int32_t *acc, const int16_t *buf, unsigned samples) {
+  for (unsigned i = 0; i < samples*2; i++) {
+    acc[i] = buf[i];
+  }
+}
+
+// clamp the mix bus into int16 stereo frames
+static inline void opna_mix32_store(int16_t *buf, const int32_t *acc, unsigned samples) {
+  unsigned i = 0;
+#ifdef ENABLE_WASM_SIMD
+  // narrow saturates to int16
+  for (; i + 8 <= samples*2; i += 8) {
+    v128_t lo = wasm_v128_load(&acc[i]);
+    v128_t hi = wasm_v128_load(&acc[i+4]);
+    wasm_v128_store(&buf[i], wasm_i16x8_narrow_i32x4(lo, hi));
+  }
+#endif
+  for (; i < samples*2; i++) {
+    int32_t o = acc[i];
+    if (o < INT16_MIN) o = INT16_MIN;
+    if (o > INT16_MAX) o = INT16_MAX;
+    buf[i] = o;
+  }
+}
+
+// clamp the mix bus into float planar frames, 1.0 is 32768
+static inline void opna_mix32_store_f32(float *l, float *r, const int32_t *acc, unsigned samples) {
+  unsigned i = 0;
+#ifdef ENABLE_WASM_SIMD
+  // 4 frames per loop
+  for (; i + 4 <= samples; i += 4) {
+    v128_t a = wasm_v128_load(&acc[i*2]);
+    v128_t b = wasm_v128_load(&acc[i*2+4]);
+    a = wasm_i32x4_min(wasm_i32x4_max(a, wasm_i32x4_splat(INT16_MIN)), wasm_i32x4_splat(INT16_MAX));
+    b = wasm_i32x4_min(wasm_i32x4_max(b, wasm_i32x4_splat(INT16_MIN)), wasm_i32x4_splat(INT16_MAX));
+    v128_t scale = wasm_f32x4_splat(1.0f / 32768);
+    v128_t lo = wasm_i32x4_shuffle(a, b, 0, 2, 4, 6);
+    v128_t ro = wasm_i32x4_shuffle(a, b, 1, 3, 5, 7);
+    wasm_v128_store(&l[i], wasm_f32x4_mul(wasm_f32x4_convert_i32x4(lo), scale));
+    wasm_v128_store(&r[i], wasm_f32x4_mul(wasm_f32x4_convert_i32x4(ro), scale));
+  }
+#endif
+  for (; i < samples; i++) {
+    int32_t lo = acc[i*2+0];
+    int32_t ro = acc[i*2+1];
+    if (lo < INT16_MIN) lo = INT16_MIN;
+    if (lo > INT16_MAX) lo = INT16_MAX;
+    if (ro < INT16_MIN) ro = INT16_MIN;
+    if (ro > INT16_MAX) ro = INT16_MAX;
+    l[i] = lo * (1.0f / 32768);
+    r[i] = ro * (1.0f / 32768);
+  }
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LIBOPNA_OPNAMIX_H_INCLUDED
@@ -0,0 +1,26 @@
+#include "opnaratecvt.h"
+#include <emmintrin.h>
+
+void opna_ratecvt_calc_sse2(const float *l, const float *r,
+                            const float (*coeff)[OPNA_RATECVT_TAPS],
+                            float *out) {
+  __m128 l0 = _mm_setzero_ps();
+  __m128 l1 = _mm_setzero_ps();
+  __m128 r0 = _mm_setzero_ps();
+  __m128 r1 = _mm_setzero_ps();
+  for (int k = 0; k < OPNA_RATECVT_TAPS; k += 4) {
+    __m128 lin = _mm_loadu_ps(&l[k]);
+    __m128 rin = _mm_loadu_ps(&r[k]);
+    __m128 c0 = _mm_loadu_ps(&coeff[0][k]);
+    __m128 c1 = _mm_loadu_ps(&coeff[1][k]);
+    l0 = _mm_add_ps(l0, _mm_mul_ps(lin, c0));
+    l1 = _mm_add_ps(l1, _mm_mul_ps(lin, c1));
+    r0 = _mm_add_ps(r0, _mm_mul_ps(rin, c0));
+    r1 = _mm_add_ps(r1, _mm_mul_ps(rin, c1));
+  }
+  // {l0, l1, r0, r1}
+  __m128 t0 = _mm_add_ps(_mm_unpacklo_ps(l0, l1), _mm_unpackhi_ps(l0, l1));
+  __m128 t1 = _mm_add_ps(_mm_unpacklo_ps(r0, r1), _mm_unpackhi_ps(r0, r1));
+  __m128 sum = _mm_add_ps(_mm_movelh_ps(t0, t1), _mm_movehl_ps(t1, t0));
+  _mm_storeu_ps(out, sum);
+}
@@ -0,0 +1,155 @@
+#include "opnaratecvt.h"
+#include "opnatimer.h"
+#include "opnamix.h"
+#include <string.h>
+
+#include "opnaratecvt-table.inc"
+
+#ifdef ENABLE_SSE
+opna_ratecvt_calc_func_type opna_ratecvt_calc_func = opna_ratecvt_calc_sse2;
+#else
+opna_ratecvt_calc_func_type opna_ratecvt_calc_func = opna_ratecvt_calc_c;
+#endif
+
+enum {
+  // samples needed before and after the output position
+  HIST = OPNA_RATECVT_TAPS/2 - 1,
+  AHEAD = OPNA_RATECVT_TAPS/2,
+  PHASE_SHIFT = 32 - 7,
+};
+
+void opna_ratecvt_calc_c(const float *l, const float *r,
+                         const float (*coeff)[OPNA_RATECVT_TAPS],
+                         float *out) {
+  // summed in the same order as the SIMD kernel, the products are
+  // separate statements so that they are not contracted into FMAs
+  // (unless contraction across statements is enabled, as with gcc -std=gnu*)
+  float acc[4][4] = {{0}};
+  for (int k = 0; k < OPNA_RATECVT_TAPS; k += 4) {
+    for (int j = 0; j < 4; j++) {
+      float l0 = l[k+j] * coeff[0][k+j];
+      float l1 = l[k+j] * coeff[1][k+j];
+      float r0 = r[k+j] * coeff[0][k+j];
+      float r1 = r[k+j] * coeff[1][k+j];
+      acc[0][j] += l0;
+      acc[1][j] += l1;
+      acc[2][j] += r0;
+      acc[3][j] += r1;
+    }
+  }
+  for (int i = 0; i < 4; i++) {
+    out[i] = (acc[i][0] + acc[i][2]) + (acc[i][1] + acc[i][3]);
+  }
+}
+
+bool opna_ratecvt_init(struct opna_ratecvt *cvt, unsigned outrate) {
+  if (outrate < OPNA_RATECVT_MIN_OUTRATE || outrate > OPNA_RATECVT_MAX_OUTRATE) {
+    return false;
+  }
+  cvt->step = ((uint64_t)OPNA_RATECVT_SRATE << 32) / outrate;
+  opna_ratecvt_reset(cvt);
+  return true;
+}
+
+void opna_ratecvt_reset(struct opna_ratecvt *cvt) {
+  // silence before the first sample
+  for (int c = 0; c < 2; c++) {
+    for (int i = 0; i < HIST; i++) cvt->buf[c][i] = 0;
+  }
+  cvt->buflen = HIST;
+  cvt->pos = (uint64_t)HIST << 32;
+}
+
+// generate native samples so that buf has at least need samples
+// straight from the int32 mix bus, before it is clamped
+static void ratecvt_fill(struct opna_ratecvt *cvt, struct opna_timer *timer,
+                         unsigned need, struct oscillodata *oscillo) {
+  // drop samples no longer needed for the history
+  unsigned start = (cvt->pos >> 32) - HIST;
+  if (start) {
+    unsigned keep = cvt->buflen - start;
+    for (int c = 0; c < 2; c++) {
+      memmove(cvt->buf[c], cvt->buf[c] + start, keep * sizeof(float));
+    }
+    cvt->buflen = keep;
+    cvt->pos -= (uint64_t)start << 32;
+    need -= start;
+  }
+  if (need > OPNA_RATECVT_BUFLEN) need = OPNA_RATECVT_BUFLEN;
+  while (cvt->buflen < need) {
+    int32_t acc[OPNA_MIX32_CHUNK*2];
+    unsigned samples = need - cvt->buflen;
+    if (samples > OPNA_MIX32_CHUNK) samples = OPNA_MIX32_CHUNK;
+    for (unsigned i = 0; i < samples*2; i++) acc[i] = 0;
+    opna_timer_mix32_acc(timer, acc, samples, oscillo);
+    for (unsigned i = 0; i < samples; i++) {
+      cvt->buf[0][cvt->buflen + i] = acc[i*2+0];
+      cvt->buf[1][cvt->buflen + i] = acc[i*2+1];
+    }
+    cvt->buflen += samples;
+  }
+}
+
+// next output frame, left is the number of output frames still wanted
+// including this one
+static void ratecvt_calc(struct opna_ratecvt *cvt, struct opna_timer *timer,
+                         unsigned left, struct oscillodata *oscillo,
+                         float *out) {
+  unsigned n = cvt->pos >> 32;
+  if (n + AHEAD >= cvt->buflen) {
+    // native samples needed for the rest of the output
+    uint64_t last = (cvt->pos + (uint64_t)(left - 1) * cvt->step) >> 32;
+    ratecvt_fill(cvt, timer, last + AHEAD + 1, oscillo);
+    n = cvt->pos >> 32;
+  }
+  uint32_t frac = cvt->pos;
+  unsigned phase = frac >> PHASE_SHIFT;
+  float phasefrac = (frac & ((1u << PHASE_SHIFT) - 1)) * (1.0f / (1u << PHASE_SHIFT));
+  float dot[4];
+  opna_ratecvt_calc_func(&cvt->buf[0][n - HIST], &cvt->buf[1][n - HIST],
+                         &opna_ratecvt_table[phase], dot);
+  // interpolate between the two phases
+  out[0] = dot[0] + (dot[1] - dot[0]) * phasefrac;
+  out[1] = dot[2] + (dot[3] - dot[2]) * phasefrac;
+  cvt->pos += cvt->step;
+}
+
+static int16_t ratecvt_add(int16_t a, float b) {
+  // round half away from zero without libm
+  int32_t o = a + (int32_t)(b < 0 ? b - 0.5f : b + 0.5f);
+  if (o < INT16_MIN) o = INT16_MIN;
+  if (o > INT16_MAX) o = INT16_MAX;
+  return o;
+}
+
+static float ratecvt_f32(float v) {
+  if (v < INT16_MIN) v = INT16_MIN;
+  if (v > INT16_MAX) v = INT16_MAX;
+  return v * (1.0f / 32768);
+}
+
+void opna_ratecvt_mix(struct opna_ratecvt *cvt, struct opna_timer *timer,
+                      int16_t *buf, unsigned frames) {
+  for (unsigned i = 0; i < frames; i++) {
+    float out[2];
+    ratecvt_calc(cvt, timer, frames - i, 0, out);
+    buf[i*2+0] = ratecvt_add(buf[i*2+0], out[0]);
+    buf[i*2+1] = ratecvt_add(buf[i*2+1], out[1]);
+  }
+}
+
+void opna_ratecvt_mix_f32(struct opna_ratecvt *cvt, struct opna_timer *timer,
+                          float *l, float *r, unsigned frames) {
+  opna_ratecvt_mix_f32_oscillo(cvt, timer, l, r, frames, 0);
+}
+
+void opna_ratecvt_mix_f32_oscillo(struct opna_ratecvt *cvt, struct opna_timer *timer,
+                                  float *l, float *r, unsigned frames,
+                                  struct oscillodata *oscillo) {
+  for (unsigned i = 0; i < frames; i++) {
+    float out[2];
+    ratecvt_calc(cvt, timer, frames - i, oscillo, out);
+    l[i] = ratecvt_f32(out[0]);
+    r[i] = ratecvt_f32(out[1]);
+  }
+}
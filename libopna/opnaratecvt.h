@@ -0,0 +1,74 @@
+#ifndef LIBOPNA_OPNARATECVT_H_INCLUDED
+#define LIBOPNA_OPNARATECVT_H_INCLUDED
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// output at a rate other than the native 55467 Hz:
+// the chips keep running at the native rate and the int32 mix bus
+// is converted with one polyphase windowed sinc filter
+// (64 taps, 128 phases with linear interpolation between them,
+// passband up to about 18 kHz)
+enum {
+  OPNA_RATECVT_SRATE = 55467,
+  // supported output rates, anything between works
+  OPNA_RATECVT_MIN_OUTRATE = 44100,
+  OPNA_RATECVT_MAX_OUTRATE = OPNA_RATECVT_SRATE,
+  OPNA_RATECVT_TAPS = 64,
+  OPNA_RATECVT_PHASES = 128,
+  // native samples buffered, including the filter history
+  OPNA_RATECVT_BUFLEN = 1024,
+};
+
+struct opna_timer;
+struct oscillodata;
+
+struct opna_ratecvt {
+  // native samples per output sample, 32.32 fixed point
+  uint64_t step;
+  // position of the next output sample in buf, 32.32 fixed point
+  uint64_t pos;
+  // valid samples in buf
+  unsigned buflen;
+  float buf[2][OPNA_RATECVT_BUFLEN];
+};
+
+// returns false if outrate is not supported
+bool opna_ratecvt_init(struct opna_ratecvt *cvt, unsigned outrate);
+// call after seeking or loading a new song to drop the buffered samples
+void opna_ratecvt_reset(struct opna_ratecvt *cvt);
+// generates with opna_timer_mix32_acc and adds frames output samples to buf
+// the timer runs ahead of the output by up to OPNA_RATECVT_TAPS/2 native samples
+void opna_ratecvt_mix(struct opna_ratecvt *cvt, struct opna_timer *timer,
+                      int16_t *buf, unsigned frames);
+// float planar output written (not added) to l and r, 1.0 is 32768
+void opna_ratecvt_mix_f32(struct opna_ratecvt *cvt, struct opna_timer *timer,
+                          float *l, float *r, unsigned frames);
+void opna_ratecvt_mix_f32_oscillo(struct opna_ratecvt *cvt, struct opna_timer *timer,
+                                  float *l, float *r, unsigned frames,
+                                  struct oscillodata *oscillo);
+
+// dot products of OPNA_RATECVT_TAPS samples of both channels with two
+// adjacent phases: out = {l*coeff[0], l*coeff[1], r*coeff[0], r*coeff[1]}
+typedef void (*opna_ratecvt_calc_func_type)(const float *l, const float *r,
+                                            const float (*coeff)[OPNA_RATECVT_TAPS],
+                                            float *out);
+extern opna_ratecvt_calc_func_type opna_ratecvt_calc_func;
+void opna_ratecvt_calc_c(const float *l, const float *r,
+                         const float (*coeff)[OPNA_RATECVT_TAPS],
+                         float *out) __attribute__((hot, optimize(3)));
+void opna_ratecvt_calc_sse2(const float *l, const float *r,
+                            const float (*coeff)[OPNA_RATECVT_TAPS],
+                            float *out) __attribute__((hot, optimize(3)));
+
+extern const float opna_ratecvt_table[OPNA_RATECVT_PHASES+1][OPNA_RATECVT_TAPS];
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LIBOPNA_OPNARATECVT_H_INCLUDED
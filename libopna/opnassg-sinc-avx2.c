@@ -0,0 +1,27 @@
+#include "libopna/opnassg.h"
+#include <immintrin.h>
+
+void opna_ssg_sinc_calc_avx2(unsigned resampler_index, const int16_t *inbuf, int32_t *outbuf) {
+  inbuf += resampler_index >> 1;
+  const int16_t *sinctable = opna_ssg_sinctable;
+  if (!(resampler_index & 1u)) sinctable += OPNA_SSG_SINCTABLELEN;
+  __m256i outacc[3];
+  for (int c = 0; c < 3; c++) {
+    outacc[c] = _mm256_setzero_si256();
+  }
+  for (int j = 0; j < OPNA_SSG_SINCTABLELEN; j += 16) {
+    // 16 samples per loop
+    __m256i sinc = _mm256_loadu_si256((const __m256i *)&sinctable[j]);
+    for (int c = 0; c < 3; c++) {
+      __m256i in = _mm256_loadu_si256((const __m256i *)&inbuf[c*OPNA_SSG_RESAMPLER_STRIDE + j]);
+      outacc[c] = _mm256_add_epi32(outacc[c], _mm256_madd_epi16(in, sinc));
+    }
+  }
+  for (int c = 0; c < 3; c++) {
+    __m128i acc = _mm_add_epi32(_mm256_castsi256_si128(outacc[c]),
+                                _mm256_extracti128_si256(outacc[c], 1));
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, 0x4e));
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, 0xb1));
+    outbuf[c] = _mm_cvtsi128_si32(acc);
+  }
+}
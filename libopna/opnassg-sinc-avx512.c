@@ -0,0 +1,23 @@
+#include "libopna/opnassg.h"
+#include <immintrin.h>
+
+void opna_ssg_sinc_calc_avx512(unsigned resampler_index, const int16_t *inbuf, int32_t *outbuf) {
+  inbuf += resampler_index >> 1;
+  const int16_t *sinctable = opna_ssg_sinctable;
+  if (!(resampler_index & 1u)) sinctable += OPNA_SSG_SINCTABLELEN;
+  __m512i outacc[3];
+  for (int c = 0; c < 3; c++) {
+    outacc[c] = _mm512_setzero_si512();
+  }
+  for (int j = 0; j < OPNA_SSG_SINCTABLELEN; j += 32) {
+    // 32 samples per loop
+    __m512i sinc = _mm512_loadu_si512((const void *)&sinctable[j]);
+    for (int c = 0; c < 3; c++) {
+      __m512i in = _mm512_loadu_si512((const void *)&inbuf[c*OPNA_SSG_RESAMPLER_STRIDE + j]);
+      outacc[c] = _mm512_add_epi32(outacc[c], _mm512_madd_epi16(in, sinc));
+    }
+  }
+  for (int c = 0; c < 3; c++) {
+    outbuf[c] = _mm512_reduce_add_epi32(outacc[c]);
+  }
+}
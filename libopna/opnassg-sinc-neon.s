@@ -1,15 +1,16 @@
 @ neon register map:
-@  0,  3,  6,  9, 12, 15 ssg1
-@  1,  4,  7, 10, 13, 16 ssg2
-@  2,  5,  8, 11, 14, 17 ssg3
-@ 18, 19, 20, 21, 22, 23 sinc
+@  0-3   ssg1 (16 samples)
+@  4-7   ssg2
+@ 16-19  ssg3
+@ 20-23  sinc
 @ 24-25 (q12): ssg1 out
 @ 26-27 (q13): ssg2 out
 @ 28-29 (q14): ssg3 out
+@ d8-d15 are callee-saved and not used
 
 .global opna_ssg_sinc_calc_neon
 @ r0: resampler_index
-@ r1: const int16_t *inbuf
+@ r1: const int16_t *inbuf (planar, 256 samples per channel)
 @ r2: int32_t *outbuf
 
 opna_ssg_sinc_calc_neon:
@@ -20,67 +21,48 @@ opna_ssg_sinc_calc_neon:
   addeq r3, #256
 
 @ add offset to ssg input buffer address
+@ (resampler_index>>1) samples, 2 bytes each
   bic r0, #1
-  add r1, r0, lsl #2
+  add r1, r0
+@ channel 2 and 3 input
+  add r12, r1, #512
+  add r0, r1, #1024
 
 @ initialize output register
   vmov.i64 q12, #0
   vmov.i64 q13, #0
   vmov.i64 q14, #0
 
-@ sinc sample length
-  mov r0, #128
+@ sinc sample length / 16
+  push {r4}
+  mov r4, #8
 
 .loop:
-@
-  subs r0, #24
-  blo .end
-
 @ load SSG channel data
-  vld4.16 {d0-d3}, [r1]!
-  vld4.16 {d3-d6}, [r1]!
-  vld4.16 {d6-d9}, [r1]!
-  vld4.16 {d9-d12}, [r1]!
-  vld4.16 {d12-d15}, [r1]!
-  vld4.16 {d15-d18}, [r1]!
+  vld1.16 {d0-d3}, [r1]!
+  vld1.16 {d4-d7}, [r12]!
+  vld1.16 {d16-d19}, [r0]!
 
 @ load sinc data
-  vld1.16 {d18-d21}, [r3]!
-  vld1.16 {d22-d23}, [r3]!
+  vld1.16 {d20-d23}, [r3]!
 
 @ multiply and accumulate
-  vmlal.s16 q12, d0,  d18
-  vmlal.s16 q13, d1,  d18
-  vmlal.s16 q14, d2,  d18
-  vmlal.s16 q12, d3,  d19
-  vmlal.s16 q13, d4,  d19
-  vmlal.s16 q14, d5,  d19
-  vmlal.s16 q12, d6,  d20
-  vmlal.s16 q13, d7,  d20
-  vmlal.s16 q14, d8,  d20
-  vmlal.s16 q12, d9,  d21
-  vmlal.s16 q13, d10, d21
-  vmlal.s16 q14, d11, d21
-  vmlal.s16 q12, d12, d22
-  vmlal.s16 q13, d13, d22
-  vmlal.s16 q14, d14, d22
-  vmlal.s16 q12, d15, d23
-  vmlal.s16 q13, d16, d23
-  vmlal.s16 q14, d17, d23
-  b .loop
-
-.end:
-@ 8 samples left
-  vld4.16 {d0-d3}, [r1]!
-  vld4.16 {d3-d6}, [r1]
-  vld1.16 {d18-d19}, [r3]
+  vmlal.s16 q12, d0,  d20
+  vmlal.s16 q13, d4,  d20
+  vmlal.s16 q14, d16, d20
+  vmlal.s16 q12, d1,  d21
+  vmlal.s16 q13, d5,  d21
+  vmlal.s16 q14, d17, d21
+  vmlal.s16 q12, d2,  d22
+  vmlal.s16 q13, d6,  d22
+  vmlal.s16 q14, d18, d22
+  vmlal.s16 q12, d3,  d23
+  vmlal.s16 q13, d7,  d23
+  vmlal.s16 q14, d19, d23
 
-  vmlal.s16 q12, d0, d18
-  vmlal.s16 q13, d1, d18
-  vmlal.s16 q14, d2, d18
-  vmlal.s16 q12, d3, d19
-  vmlal.s16 q13, d4, d19
-  vmlal.s16 q14, d5, d19
+  subs r4, #1
+  bne .loop
+  pop {r4}
 
 @ extract data from result SIMD registers
   vpadd.i32 d0, d24, d25
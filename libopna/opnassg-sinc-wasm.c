@@ -0,0 +1,25 @@
+#include "libopna/opnassg.h"
+#include <wasm_simd128.h>
+
+void opna_ssg_sinc_calc_wasm(unsigned resampler_index, const int16_t *inbuf, int32_t *outbuf) {
+  inbuf += resampler_index >> 1;
+  const int16_t *sinctable = opna_ssg_sinctable;
+  if (!(resampler_index & 1u)) sinctable += OPNA_SSG_SINCTABLELEN;
+  v128_t outacc[3];
+  for (int c = 0; c < 3; c++) {
+    outacc[c] = wasm_i32x4_const_splat(0);
+  }
+  for (int j = 0; j < OPNA_SSG_SINCTABLELEN; j += 8) {
+    // 8 samples per loop
+    v128_t sinc = wasm_v128_load(&sinctable[j]);
+    for (int c = 0; c < 3; c++) {
+      v128_t in = wasm_v128_load(&inbuf[c*OPNA_SSG_RESAMPLER_STRIDE + j]);
+      outacc[c] = wasm_i32x4_add(outacc[c], wasm_i32x4_dot_i16x8(in, sinc));
+    }
+  }
+  for (int c = 0; c < 3; c++) {
+    outacc[c] = wasm_i32x4_add(outacc[c], wasm_i32x4_shuffle(outacc[c], outacc[c], 2, 3, 0, 1));
+    outacc[c] = wasm_i32x4_add(outacc[c], wasm_i32x4_shuffle(outacc[c], outacc[c], 1, 0, 3, 2));
+    outbuf[c] = wasm_i32x4_extract_lane(outacc[c], 0);
+  }
+}
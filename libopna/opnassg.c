@@ -1,4 +1,5 @@
 #include "opnassg.h"
+#include "opnamix.h"
 #ifdef LIBOPNA_ENABLE_OSCILLO
 #include "oscillo/oscillo.h"
 #endif
@@ -141,7 +142,12 @@ const int16_t opna_ssg_sinctable[OPNA_SSG_SINCTABLELEN*2] = {
      16,     7,    -2,    -6,    -6,    -3,    -1,     1,
 };
 
+#ifdef ENABLE_WASM_SIMD
+// the web player does not call opna_cpu_select
+opna_ssg_sinc_calc_func_type opna_ssg_sinc_calc_func = opna_ssg_sinc_calc_wasm;
+#else
 opna_ssg_sinc_calc_func_type opna_ssg_sinc_calc_func = opna_ssg_sinc_calc_c;
+#endif
 
 void opna_ssg_reset(struct opna_ssg *ssg) {
   *ssg = (struct opna_ssg) {
@@ -151,10 +157,11 @@ void opna_ssg_reset(struct opna_ssg *ssg) {
 }
 
 void opna_ssg_resampler_reset(struct opna_ssg_resampler *resampler) {
-  for (int i = 0; i < OPNA_SSG_SINCTABLELEN; i++) {
-    resampler->buf[i] = 0;
-  }
+  memset(resampler->buf, 0, sizeof(resampler->buf));
   resampler->index = 0;
+  memset(resampler->steady, 0, sizeof(resampler->steady));
+  resampler->steady_cnt = 0;
+  resampler->steady_out_valid = false;
 #ifdef LIBOPNA_ENABLE_LEVELDATA
   for (int c = 0; c < 3; c++) {
     leveldata_init(&resampler->leveldata[c]);
@@ -238,76 +245,241 @@ int opna_ssg_channel_level(const struct opna_ssg *ssg, int ch) {
 #define COEFF 0x3fff
 #define COEFFSH 14
 
-// 3 samples per frame
-// output buf: 0 1 2 x 0 1 2 x ...
-void opna_ssg_generate_raw(struct opna_ssg *ssg, int16_t *buf, int samples) {
-  for (int i = 0; i < samples; i++) {
-    if (((++ssg->noise_counter) >> 1) >= opna_ssg_noise_period(ssg)) {
-      ssg->noise_counter = 0;
-      ssg->lfsr |= (!((ssg->lfsr & 1) ^ ((ssg->lfsr >> 3) & 1))) << 17;
-      ssg->lfsr >>= 1;
-    }
-    if (!ssg->env_holding) {
-      if (++ssg->env_counter >= opna_ssg_env_period(ssg)) {
-        ssg->env_counter = 0;
-        ssg->env_level++;
-        if (ssg->env_level == 0x20) {
-          ssg->env_level = 0;
-          if (ssg->env_alt) {
-            ssg->env_att = !ssg->env_att;
-          }
-          if (ssg->env_hld) {
-            ssg->env_level = 0x1f;
-            ssg->env_holding = true;
-          }
-        }
+// the generator state is a set of counters that are incremented every sample
+// and reset to 0 when they reach their period ("fire")
+
+// samples until the counter fires (the firing sample included)
+static unsigned opna_ssg_counter_next(unsigned counter, unsigned period) {
+  return (counter + 1 >= period) ? 1 : period - counter;
+}
+
+// advance the counter, returns how many times it fired
+static unsigned opna_ssg_counter_skip(unsigned *counter, unsigned period, unsigned samples) {
+  if (period <= 1) {
+    if (samples) *counter = 0;
+    return samples;
+  }
+  unsigned first = opna_ssg_counter_next(*counter, period);
+  if (samples < first) {
+    *counter += samples;
+    return 0;
+  }
+  samples -= first;
+  *counter = samples % period;
+  return 1 + samples / period;
+}
+
+static void opna_ssg_noise_skip(struct opna_ssg *ssg, unsigned samples) {
+  unsigned counter = ssg->noise_counter;
+  unsigned steps = opna_ssg_counter_skip(&counter, opna_ssg_noise_period(ssg)*2, samples);
+  ssg->noise_counter = counter;
+  for (unsigned i = 0; i < steps; i++) {
+    ssg->lfsr |= (!((ssg->lfsr & 1) ^ ((ssg->lfsr >> 3) & 1))) << 17;
+    ssg->lfsr >>= 1;
+  }
+}
+
+static void opna_ssg_env_skip(struct opna_ssg *ssg, unsigned samples) {
+  if (ssg->env_holding) return;
+  unsigned counter = ssg->env_counter;
+  unsigned steps = opna_ssg_counter_skip(&counter, opna_ssg_env_period(ssg), samples);
+  for (unsigned i = 0; i < steps && !ssg->env_holding; i++) {
+    ssg->env_level++;
+    if (ssg->env_level == 0x20) {
+      ssg->env_level = 0;
+      if (ssg->env_alt) {
+        ssg->env_att = !ssg->env_att;
+      }
+      if (ssg->env_hld) {
+        ssg->env_level = 0x1f;
+        ssg->env_holding = true;
       }
     }
+  }
+  // the counter stops at 0 once the envelope holds
+  ssg->env_counter = ssg->env_holding ? 0 : counter;
+}
 
-    //int16_t out = 0;
-    for (int ch = 0; ch < 3; ch++) {
-      buf[i*4+ch] = 0;
-      if (++ssg->ch[ch].tone_counter >= opna_ssg_tone_period(ssg, ch)) {
-        ssg->ch[ch].tone_counter = 0;
-        ssg->ch[ch].out = !ssg->ch[ch].out;
+static void opna_ssg_tone_skip(struct opna_ssg *ssg, int ch, unsigned samples) {
+  unsigned counter = ssg->ch[ch].tone_counter;
+  unsigned steps = opna_ssg_counter_skip(&counter, opna_ssg_tone_period(ssg, ch), samples);
+  ssg->ch[ch].tone_counter = counter;
+  if (steps & 1) ssg->ch[ch].out = !ssg->ch[ch].out;
+}
+
+// which counters can change the output
+struct opna_ssg_used {
+  bool noise;
+  bool env;
+  bool tone[3];
+};
+
+static void opna_ssg_skip(struct opna_ssg *ssg, const struct opna_ssg_used *used, unsigned samples) {
+  if (used->noise) opna_ssg_noise_skip(ssg, samples);
+  if (used->env) opna_ssg_env_skip(ssg, samples);
+  for (int ch = 0; ch < 3; ch++) {
+    if (used->tone[ch]) opna_ssg_tone_skip(ssg, ch, samples);
+  }
+}
+
+// same state changes as opna_ssg_generate_raw, without the output
+static void opna_ssg_skip_raw(struct opna_ssg *ssg, unsigned samples) {
+  const struct opna_ssg_used all = {true, true, {true, true, true}};
+  opna_ssg_skip(ssg, &all, samples);
+}
+
+// output samples while no counter fires (tone, noise and envelope level fixed)
+static void opna_ssg_emit(struct opna_ssg *ssg, int16_t *buf, unsigned samples) {
+  for (int ch = 0; ch < 3; ch++) {
+    int level = opna_ssg_channel_level(ssg, ch);
+    if (!ssg->ymf288) {
+      // OPNA output level + HPF
+      int32_t in = opna_ssg_tone_out(ssg, ch) ? voltable[level]*5 : 0;
+      in *= COEFF;
+      int32_t previn = ssg->previn[ch];
+      int32_t prevout = ssg->prevout[ch];
+      for (unsigned i = 0; i < samples; i++) {
+        prevout = in - previn + ((((int64_t)COEFF)*prevout) >> COEFFSH);
+        previn = in;
+        buf[i*4+ch] = prevout >> COEFFSH;
       }
-      if (!ssg->ymf288) {
-        // OPNA output level + HPF
-        int32_t previntmp = 0;
-        if (opna_ssg_tone_out(ssg, ch)) {
-          int level = opna_ssg_channel_level(ssg, ch);
-          previntmp = voltable[level]*5;
-        }
-        previntmp *= COEFF;
-        ssg->prevout[ch] = previntmp - ssg->previn[ch] + ((((int64_t)COEFF)*ssg->prevout[ch]) >> COEFFSH);
-        ssg->previn[ch] = previntmp;
-        buf[i*4+ch] = ssg->prevout[ch] >> COEFFSH;
+      ssg->previn[ch] = previn;
+      ssg->prevout[ch] = prevout;
+    } else {
+      // YMF288
+      int16_t out;
+      if (!opna_ssg_tone_silent(ssg, ch)) {
+        out = (opna_ssg_tone_out_ymf288(ssg, ch) ? voltable[level] : -voltable[level]);
       } else {
-        // YMF288
-        int level = opna_ssg_channel_level(ssg, ch);
-        if (!opna_ssg_tone_silent(ssg, ch)) {
-          buf[i*4+ch] = (opna_ssg_tone_out_ymf288(ssg, ch) ? voltable[level] : -voltable[level]);
-        } else {
-          buf[i*4+ch] = voltable[level]*2;
-        }
+        out = voltable[level]*2;
+      }
+      for (unsigned i = 0; i < samples; i++) {
+        buf[i*4+ch] = out;
       }
-      
     }
-    //buf[i] = out / 2;
   }
 }
 
+// 3 samples per frame
+// output buf: 0 1 2 x 0 1 2 x ...
+// only the samples where a counter that affects the output fires are stepped
+// one at a time, the spans in between are filled with the state fixed
+void opna_ssg_generate_raw(struct opna_ssg *ssg, int16_t *buf, int samples) {
+  if (samples <= 0) return;
+  // registers do not change during a call
+  struct opna_ssg_used used = {0};
+  for (int ch = 0; ch < 3; ch++) {
+    unsigned reg = ssg->regs[0x7] >> ch;
+    if (!(reg & 0x8)) used.noise = true;
+    if (opna_ssg_chan_env(ssg, ch)) used.env = true;
+    used.tone[ch] = !(reg & 0x1) &&
+        !(ssg->ymf288 && opna_ssg_tone_period(ssg, ch) < 8);
+  }
+  unsigned noise_period = opna_ssg_noise_period(ssg)*2;
+  unsigned env_period = opna_ssg_env_period(ssg);
+  unsigned tone_period[3];
+  for (int ch = 0; ch < 3; ch++) {
+    tone_period[ch] = opna_ssg_tone_period(ssg, ch);
+  }
+  unsigned total = samples;
+  while (samples > 0) {
+    unsigned next = samples + 1;
+    if (used.noise) {
+      unsigned noise_next = opna_ssg_counter_next(ssg->noise_counter, noise_period);
+      if (noise_next < next) next = noise_next;
+    }
+    if (used.env && !ssg->env_holding) {
+      unsigned env_next = opna_ssg_counter_next(ssg->env_counter, env_period);
+      if (env_next < next) next = env_next;
+    }
+    for (int ch = 0; ch < 3; ch++) {
+      if (!used.tone[ch]) continue;
+      unsigned tone_next = opna_ssg_counter_next(ssg->ch[ch].tone_counter, tone_period[ch]);
+      if (tone_next < next) next = tone_next;
+    }
+    // samples before the next event
+    unsigned run = next - 1;
+    if (run) {
+      opna_ssg_skip(ssg, &used, run);
+      opna_ssg_emit(ssg, buf, run);
+      buf += run*4;
+      samples -= run;
+    }
+    if (samples) {
+      opna_ssg_skip(ssg, &used, 1);
+      opna_ssg_emit(ssg, buf, 1);
+      buf += 4;
+      samples--;
+    }
+  }
+  // the rest does not change the output and can be advanced at once
+  struct opna_ssg_used unused = {
+    .noise = !used.noise,
+    .env = !used.env,
+    .tone = {!used.tone[0], !used.tone[1], !used.tone[2]},
+  };
+  opna_ssg_skip(ssg, &unused, total);
+}
+
+// true if the raw output of the channel stays at *out until the registers change
+// (level fixed, tone and noise either off or inaudible, HPF settled)
+static bool opna_ssg_chan_quiet(const struct opna_ssg *ssg, int ch, int16_t *out) {
+  if (opna_ssg_chan_env(ssg, ch) && !ssg->env_holding) return false;
+  int32_t v = voltable[opna_ssg_channel_level(ssg, ch)];
+  bool silent = opna_ssg_tone_silent(ssg, ch);
+  if (v && !silent) return false;
+  if (ssg->ymf288) {
+    *out = silent ? v*2 : 0;
+    return true;
+  }
+  int32_t in = silent ? v*5*COEFF : 0;
+  if (ssg->previn[ch] != in) return false;
+  if (((((int64_t)COEFF)*ssg->prevout[ch]) >> COEFFSH) != ssg->prevout[ch]) return false;
+  *out = ssg->prevout[ch] >> COEFFSH;
+  return true;
+}
+
+// true if the resampler output stays constant until the registers change
+static bool opna_ssg_quiet(const struct opna_ssg *ssg,
+                           const struct opna_ssg_resampler *resampler) {
+  if (resampler->steady_cnt < OPNA_SSG_SINCTABLELEN) return false;
+  for (int ch = 0; ch < 3; ch++) {
+    int16_t out;
+    if (!opna_ssg_chan_quiet(ssg, ch, &out)) return false;
+    if (out != resampler->steady[ch]) return false;
+  }
+  return true;
+}
+
 #define BUFINDEX(n) ((((resampler->index)>>1)+n)&(OPNA_SSG_SINCTABLELEN-1))
 
 void opna_ssg_mix_55466(
   struct opna_ssg *ssg, struct opna_ssg_resampler *resampler,
   int16_t *buf, int samples,
   struct oscillodata *oscillo, unsigned offset
+) {
+  int32_t acc[OPNA_MIX32_CHUNK*2];
+  while (samples > 0) {
+    int chunk = samples < OPNA_MIX32_CHUNK ? samples : OPNA_MIX32_CHUNK;
+    opna_mix32_load(acc, buf, chunk);
+    opna_ssg_mix32_55466(ssg, resampler, acc, chunk, oscillo, offset);
+    opna_mix32_store(buf, acc, chunk);
+    buf += chunk*2;
+    offset += chunk;
+    samples -= chunk;
+  }
+}
+
+void opna_ssg_mix32_55466(
+  struct opna_ssg *ssg, struct opna_ssg_resampler *resampler,
+  int32_t *buf, int samples,
+  struct oscillodata *oscillo, unsigned offset
 ) {
 #ifdef LIBOPNA_ENABLE_OSCILLO
   if (oscillo) {
     for (unsigned c = 0; c < 3; c++) {
       unsigned period = (opna_ssg_tone_period(ssg, c) << OSCILLO_OFFSET_SHIFT) * 2 * 32 / 144;
+      oscillo[c].period = period;
       if (period) {
         oscillo[c].offset += (samples << OSCILLO_OFFSET_SHIFT);
         oscillo[c].offset %= period;
@@ -321,25 +493,66 @@ void opna_ssg_mix_55466(
   (void)offset;
 #endif
   unsigned level[3] = {0};
+  // registers do not change during a call,
+  // so a quiet SSG stays quiet and only its counters need to move
+  bool quiet = opna_ssg_quiet(ssg, resampler);
+  if (quiet) {
+    unsigned index = resampler->index;
+    opna_ssg_skip_raw(ssg, ((index + 9*samples)>>1) - (index>>1));
+  }
+  // raw samples are generated for RAW_BLOCK output samples at once
+  enum { RAW_BLOCK = 64 };
+  int16_t ssgbuf[(RAW_BLOCK*9/2+1)*4];
+  const int16_t *raw = ssgbuf;
   for (int i = 0; i < samples; i++) {
-    {
+    if (quiet) {
+      resampler->index += 9;
+    } else {
+      if (!(i % RAW_BLOCK)) {
+        int block = samples - i < RAW_BLOCK ? samples - i : RAW_BLOCK;
+        unsigned index = resampler->index;
+        opna_ssg_generate_raw(ssg, ssgbuf, ((index + 9*block)>>1) - (index>>1));
+        raw = ssgbuf;
+      }
       int ssg_samples = ((resampler->index + 9)>>1) - ((resampler->index)>>1);
-      int16_t ssgbuf[20];
-      opna_ssg_generate_raw(ssg, ssgbuf, ssg_samples);
       for (int j = 0; j < ssg_samples; j++) {
-        resampler->buf[BUFINDEX(j)*4+0] = ssgbuf[j*4+0];
-        resampler->buf[BUFINDEX(j)*4+1] = ssgbuf[j*4+1];
-        resampler->buf[BUFINDEX(j)*4+2] = ssgbuf[j*4+2];
+        const int16_t *in = &raw[j*4];
+        if (in[0] == resampler->steady[0] &&
+            in[1] == resampler->steady[1] &&
+            in[2] == resampler->steady[2]) {
+          // the history already holds nothing but this value
+          if (resampler->steady_cnt >= OPNA_SSG_SINCTABLELEN) continue;
+          resampler->steady_cnt++;
+        } else {
+          memcpy(resampler->steady, in, sizeof(resampler->steady));
+          resampler->steady_cnt = 1;
+          resampler->steady_out_valid = false;
+        }
+        unsigned ind = BUFINDEX(j);
+        for (int ch = 0; ch < 3; ch++) {
+          resampler->buf[ch][ind] = in[ch];
+          resampler->buf[ch][ind+OPNA_SSG_SINCTABLELEN] = in[ch];
+        }
       }
+      raw += ssg_samples*4;
       resampler->index += 9;
     }
     int32_t sample = 0;
     resampler->index &= (1u<<(OPNA_SSG_SINCTABLEBIT+1))-1;
-    memcpy(resampler->buf + OPNA_SSG_SINCTABLELEN*4, resampler->buf, OPNA_SSG_SINCTABLELEN*4*sizeof(*resampler->buf));
     int32_t outbuf[3];
     if (!ssg->ymf288) {
       // OPNA analog: bandlimited sinc resample
-      opna_ssg_sinc_calc_func(resampler->index, resampler->buf, outbuf);
+      if (resampler->steady_cnt >= OPNA_SSG_SINCTABLELEN) {
+        // silent or DC input: skip the FIR
+        if (!resampler->steady_out_valid) {
+          opna_ssg_sinc_calc_func(0, resampler->buf[0], resampler->steady_out[0]);
+          opna_ssg_sinc_calc_func(1, resampler->buf[0], resampler->steady_out[1]);
+          resampler->steady_out_valid = true;
+        }
+        memcpy(outbuf, resampler->steady_out[resampler->index & 1], sizeof(outbuf));
+      } else {
+        opna_ssg_sinc_calc_func(resampler->index, resampler->buf[0], outbuf);
+      }
       for (int ch = 0; ch < 3; ch++) {
         outbuf[ch] >>= 16;
         outbuf[ch] *= 13000;
@@ -351,16 +564,16 @@ void opna_ssg_mix_55466(
       // YMF288: average of the samples (equivalent to FIR with rectangular function
       for (int ch = 0; ch < 3; ch++) {
         int ind = (resampler->index & 1) ? BUFINDEX(5) : BUFINDEX(0);
-        outbuf[ch] = resampler->buf[ind*4+ch];
+        outbuf[ch] = resampler->buf[ch][ind];
         for (int s = 0; s < 4; s++) {
-          outbuf[ch] += resampler->buf[BUFINDEX(s+1)*4+ch] * 2;
+          outbuf[ch] += resampler->buf[ch][BUFINDEX(s+1)] * 2;
         }
         outbuf[ch] /= 9;
       }
     }
     for (int ch = 0; ch < 3; ch++) {
 #ifdef LIBOPNA_ENABLE_OSCILLO
-      if (oscillo) oscillo[ch].buf[offset+i] = outbuf[ch] << 1;
+      if (oscillo) oscillo[ch].buf[(offset+i) & OSCILLO_SAMPLE_MASK] = outbuf[ch] << 1;
 #endif
       int32_t nlevel = outbuf[ch];
       if (nlevel < 0) nlevel = -nlevel;
@@ -368,16 +581,8 @@ void opna_ssg_mix_55466(
       if (!(ssg->mask & (1<<ch))) sample += outbuf[ch];
     }
 
-    int32_t lo = buf[i*2+0];
-    int32_t ro = buf[i*2+1];
-    lo += sample;
-    ro += sample;
-    if (lo < INT16_MIN) lo = INT16_MIN;
-    if (lo > INT16_MAX) lo = INT16_MAX;
-    if (ro < INT16_MIN) ro = INT16_MIN;
-    if (ro > INT16_MAX) ro = INT16_MAX;
-    buf[i*2+0] = lo;
-    buf[i*2+1] = ro;
+    buf[i*2+0] += sample;
+    buf[i*2+1] += sample;
   }
 #ifdef LIBOPNA_ENABLE_LEVELDATA
   for (int c = 0; c < 3; c++) {
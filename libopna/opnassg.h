@@ -38,9 +38,21 @@ struct opna_ssg {
   bool ymf288;
 };
 
+// planar history of the raw SSG output, one ring per channel
+// every sample is also written SINCTABLELEN after its ring position
+// so that the kernels can read SINCTABLELEN samples without wrapping
+#define OPNA_SSG_RESAMPLER_STRIDE (OPNA_SSG_SINCTABLELEN*2)
+
 struct opna_ssg_resampler {
-  int16_t buf[OPNA_SSG_SINCTABLELEN*4 * 2];
+  int16_t buf[3][OPNA_SSG_RESAMPLER_STRIDE];
   unsigned index;
+  // the last steady_cnt raw samples were all steady[]
+  // once it reaches SINCTABLELEN the whole history is constant, so the
+  // sinc output only depends on the index parity and is cached in steady_out
+  int16_t steady[3];
+  unsigned steady_cnt;
+  bool steady_out_valid;
+  int32_t steady_out[2][3];
 #ifdef LIBOPNA_ENABLE_LEVELDATA
   struct leveldata leveldata[3];
 #endif
@@ -64,6 +76,10 @@ struct oscillodata;
 void opna_ssg_mix_55466(
   struct opna_ssg *ssg, struct opna_ssg_resampler *resampler,
   int16_t *buf, int samples, struct oscillodata *oscillo, unsigned offset);
+// add to int32 mix bus without clamping
+void opna_ssg_mix32_55466(
+  struct opna_ssg *ssg, struct opna_ssg_resampler *resampler,
+  int32_t *buf, int samples, struct oscillodata *oscillo, unsigned offset);
 void opna_ssg_writereg(struct opna_ssg *ssg, unsigned reg, unsigned val);
 unsigned opna_ssg_readreg(const struct opna_ssg *ssg, unsigned reg);
 // channel level (0 - 31)
@@ -85,6 +101,7 @@ static inline void opna_ssg_set_mix(struct opna_ssg *ssg, uint32_t mix) {
   ssg->mix = mix;
 }
 
+// inbuf: resampler->buf, channel c starts at inbuf + c*OPNA_SSG_RESAMPLER_STRIDE
 typedef void (*opna_ssg_sinc_calc_func_type)(unsigned resampler_index,
                                              const int16_t *inbuf, int32_t *outbuf);
 extern opna_ssg_sinc_calc_func_type opna_ssg_sinc_calc_func;
@@ -92,6 +109,9 @@ void opna_ssg_sinc_calc_c(unsigned resampler_index,
                           const int16_t *inbuf, int32_t *outbuf) __attribute__((hot, optimize(3)));
 void opna_ssg_sinc_calc_neon(unsigned, const int16_t *, int32_t *);
 void opna_ssg_sinc_calc_sse2(unsigned, const int16_t *, int32_t *) __attribute__((hot, optimize(3)));
+void opna_ssg_sinc_calc_avx2(unsigned, const int16_t *, int32_t *) __attribute__((hot, optimize(3)));
+void opna_ssg_sinc_calc_avx512(unsigned, const int16_t *, int32_t *) __attribute__((hot, optimize(3)));
+void opna_ssg_sinc_calc_wasm(unsigned, const int16_t *, int32_t *) __attribute__((hot, optimize(3)));
 
 extern const int16_t opna_ssg_sinctable[OPNA_SSG_SINCTABLELEN*2];
 
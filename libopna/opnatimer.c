@@ -1,5 +1,6 @@
 #include "opnatimer.h"
 #include "opna.h"
+#include "opnamix.h"
 #include "oscillo/oscillo.h"
 
 enum {
@@ -15,6 +16,10 @@ void opna_timer_reset(struct opna_timer *timer, struct opna *opna) {
   timer->interrupt_userptr = 0;
   timer->mix_cb = 0;
   timer->mix_userptr = 0;
+  timer->mix32_cb = 0;
+  timer->mix32_userptr = 0;
+  timer->writereg_cb = 0;
+  timer->writereg_userptr = 0;
   timer->timerb = 0;
   timer->timerb_load = false;
   timer->timerb_enable = false;
@@ -35,9 +40,22 @@ void opna_timer_set_mix_callback(struct opna_timer *timer, opna_timer_mix_cb_t f
   timer->mix_userptr = userptr;
 }
 
+void opna_timer_set_mix32_callback(struct opna_timer *timer, opna_timer_mix32_cb_t func, void *userptr) {
+  timer->mix32_cb = func;
+  timer->mix32_userptr = userptr;
+}
+
+void opna_timer_set_writereg_callback(struct opna_timer *timer, opna_timer_writereg_cb_t func, void *userptr) {
+  timer->writereg_cb = func;
+  timer->writereg_userptr = userptr;
+}
+
 void opna_timer_writereg(struct opna_timer *timer, unsigned reg, unsigned val) {
   val &= 0xff;
   opna_writereg(timer->opna, reg, val);
+  if (timer->writereg_cb) {
+    timer->writereg_cb(timer->writereg_userptr, reg, val);
+  }
   switch (reg) {
   case 0x24:
     timer->timera &= ~0xff;
@@ -71,45 +89,110 @@ void opna_timer_mix(struct opna_timer *timer, int16_t *buf, unsigned samples) {
   opna_timer_mix_oscillo(timer, buf, samples, 0);
 }
 
-void opna_timer_mix_oscillo(struct opna_timer *timer, int16_t *buf, unsigned samples, struct oscillodata *oscillo) {
-  do {
-    unsigned generate_samples = samples;
-    if (timer->timerb_enable && timer->timerb_load) {
-      unsigned timerb_samples = (1<<TIMERB_BITS) - timer->timerb_cnt;
-      if (timerb_samples < generate_samples) {
-        generate_samples = timerb_samples;
+// samples to generate until next timer event
+static unsigned opna_timer_event_samples(const struct opna_timer *timer, unsigned samples) {
+  unsigned generate_samples = samples;
+  if (timer->timerb_enable && timer->timerb_load) {
+    unsigned timerb_samples = (1<<TIMERB_BITS) - timer->timerb_cnt;
+    if (timerb_samples < generate_samples) {
+      generate_samples = timerb_samples;
+    }
+  }
+  if (timer->timera_enable && timer->timera_load) {
+    unsigned timera_samples = (1<<TIMERA_BITS) - timer->timera;
+    if (timera_samples < generate_samples) {
+      generate_samples = timera_samples;
+    }
+  }
+  return generate_samples;
+}
+
+static void opna_timer_advance(struct opna_timer *timer, unsigned generate_samples) {
+  if (timer->timera_load) {
+    timer->timera = (timer->timera + generate_samples) & ((1<<TIMERA_BITS)-1);
+    if (!timer->timera && timer->timera_enable) {
+      if (!(timer->status & (1<<0))) {
+        timer->status |= (1<<0);
+        timer->interrupt_cb(timer->interrupt_userptr);
       }
     }
-    if (timer->timera_enable && timer->timera_load) {
-      unsigned timera_samples = (1<<TIMERA_BITS) - timer->timera;
-      if (timera_samples < generate_samples) {
-        generate_samples = timera_samples;
+    timer->timera &= (1<<TIMERA_BITS)-1;
+  }
+  if (timer->timerb_load) {
+    timer->timerb_cnt = (timer->timerb_cnt + generate_samples) & ((1<<TIMERB_BITS)-1);
+    if (!timer->timerb_cnt && timer->timerb_enable) {
+      if (!(timer->status & (1<<1))) {
+        timer->status |= (1<<1);
+        timer->interrupt_cb(timer->interrupt_userptr);
       }
     }
+  }
+}
+
+void opna_timer_mix_oscillo(struct opna_timer *timer, int16_t *buf, unsigned samples, struct oscillodata *oscillo) {
+  do {
+    unsigned generate_samples = opna_timer_event_samples(timer, samples);
     opna_mix_oscillo(timer->opna, buf, generate_samples, oscillo);
     if (timer->mix_cb) {
       timer->mix_cb(timer->mix_userptr, buf, generate_samples);
     }
     buf += generate_samples*2;
     samples -= generate_samples;
-    if (timer->timera_load) {
-      timer->timera = (timer->timera + generate_samples) & ((1<<TIMERA_BITS)-1);
-      if (!timer->timera && timer->timera_enable) {
-        if (!(timer->status & (1<<0))) {
-          timer->status |= (1<<0);
-          timer->interrupt_cb(timer->interrupt_userptr);
-        }
-      }
-      timer->timera &= (1<<TIMERA_BITS)-1;
-    }
-    if (timer->timerb_load) {
-      timer->timerb_cnt = (timer->timerb_cnt + generate_samples) & ((1<<TIMERB_BITS)-1);
-      if (!timer->timerb_cnt && timer->timerb_enable) {
-        if (!(timer->status & (1<<1))) {
-          timer->status |= (1<<1);
-          timer->interrupt_cb(timer->interrupt_userptr);
-        }
-      }
-    }
+    opna_timer_advance(timer, generate_samples);
   } while (samples);
 }
+
+void opna_timer_mix32(struct opna_timer *timer, int16_t *buf, unsigned samples) {
+  opna_timer_mix32_oscillo(timer, buf, samples, 0);
+}
+
+void opna_timer_mix32_acc(struct opna_timer *timer, int32_t *acc, unsigned samples, struct oscillodata *oscillo) {
+  while (samples) {
+    unsigned generate_samples = opna_timer_event_samples(timer, samples);
+    opna_mix32_oscillo(timer->opna, acc, generate_samples, oscillo);
+    if (timer->mix32_cb) {
+      timer->mix32_cb(timer->mix32_userptr, acc, generate_samples);
+    }
+    acc += generate_samples*2;
+    samples -= generate_samples;
+    opna_timer_advance(timer, generate_samples);
+  }
+}
+
+void opna_timer_mix32_oscillo(struct opna_timer *timer, int16_t *buf, unsigned samples, struct oscillodata *oscillo) {
+  int32_t acc[OPNA_MIX32_CHUNK*2];
+  while (samples) {
+    unsigned chunk = samples < OPNA_MIX32_CHUNK ? samples : OPNA_MIX32_CHUNK;
+    opna_mix32_load(acc, buf, chunk);
+    opna_timer_mix32_acc(timer, acc, chunk, oscillo);
+    opna_mix32_store(buf, acc, chunk);
+    buf += chunk*2;
+    samples -= chunk;
+  }
+}
+
+void opna_timer_mix_f32(struct opna_timer *timer, float *l, float *r, unsigned samples) {
+  opna_timer_mix_f32_oscillo(timer, l, r, samples, 0);
+}
+
+void opna_timer_mix_f32_oscillo(struct opna_timer *timer, float *l, float *r, unsigned samples, struct oscillodata *oscillo) {
+  int32_t acc[OPNA_MIX32_CHUNK*2];
+  while (samples) {
+    unsigned chunk = samples < OPNA_MIX32_CHUNK ? samples : OPNA_MIX32_CHUNK;
+    for (unsigned i = 0; i < chunk*2; i++) acc[i] = 0;
+    opna_timer_mix32_acc(timer, acc, chunk, oscillo);
+    opna_mix32_store_f32(l, r, acc, chunk);
+    l += chunk;
+    r += chunk;
+    samples -= chunk;
+  }
+}
+
+void opna_timer_skip(struct opna_timer *timer, unsigned samples) {
+  while (samples) {
+    unsigned generate_samples = opna_timer_event_samples(timer, samples);
+    timer->opna->generated_frames += generate_samples;
+    samples -= generate_samples;
+    opna_timer_advance(timer, generate_samples);
+  }
+}
@@ -10,6 +10,8 @@ extern "C" {
 
 typedef void (*opna_timer_int_cb_t)(void *ptr);
 typedef void (*opna_timer_mix_cb_t)(void *ptr, int16_t *buf, unsigned samples);
+typedef void (*opna_timer_mix32_cb_t)(void *ptr, int32_t *buf, unsigned samples);
+typedef void (*opna_timer_writereg_cb_t)(void *ptr, unsigned reg, unsigned val);
 
 struct opna;
 
@@ -20,6 +22,11 @@ struct opna_timer {
   void *interrupt_userptr;
   opna_timer_mix_cb_t mix_cb;
   void *mix_userptr;
+  opna_timer_mix32_cb_t mix32_cb;
+  void *mix32_userptr;
+  // called after every register write, e.g. to record them
+  opna_timer_writereg_cb_t writereg_cb;
+  void *writereg_userptr;
   uint16_t timera;
   uint8_t timerb;
   bool timera_load;
@@ -35,10 +42,29 @@ void opna_timer_set_int_callback(struct opna_timer *timer,
                                  opna_timer_int_cb_t func, void *userptr);
 void opna_timer_set_mix_callback(struct opna_timer *timer,
                                  opna_timer_mix_cb_t func, void *userptr);
+void opna_timer_set_mix32_callback(struct opna_timer *timer,
+                                   opna_timer_mix32_cb_t func, void *userptr);
+void opna_timer_set_writereg_callback(struct opna_timer *timer,
+                                      opna_timer_writereg_cb_t func, void *userptr);
 void opna_timer_writereg(struct opna_timer *timer, unsigned reg, unsigned val);
 void opna_timer_mix(struct opna_timer *timer, int16_t *buf, unsigned samples);
 struct oscillodata;
 void opna_timer_mix_oscillo(struct opna_timer *timer, int16_t *buf, unsigned samples, struct oscillodata *oscillo);
+// mix every block (and mix32_cb) through one int32 bus,
+// clamping to int16 only once per sample instead of once per block
+void opna_timer_mix32(struct opna_timer *timer, int16_t *buf, unsigned samples);
+void opna_timer_mix32_oscillo(struct opna_timer *timer, int16_t *buf, unsigned samples, struct oscillodata *oscillo);
+// add to the int32 mix bus without clamping, split at timer events
+// as the other mix functions, which only differ in how the bus is converted
+void opna_timer_mix32_acc(struct opna_timer *timer, int32_t *acc, unsigned samples, struct oscillodata *oscillo);
+// same mix bus as opna_timer_mix32, but writes (does not add) float planar
+// output straight into l and r, e.g. the buffers of the audio API
+// the output is the int16 output divided by 32768
+void opna_timer_mix_f32(struct opna_timer *timer, float *l, float *r, unsigned samples);
+void opna_timer_mix_f32_oscillo(struct opna_timer *timer, float *l, float *r, unsigned samples, struct oscillodata *oscillo);
+// advance the timers (and call the interrupt callback) without generating audio
+// registers are still written, but envelopes and phases do not move
+void opna_timer_skip(struct opna_timer *timer, unsigned samples);
 
 #ifdef __cplusplus
 }
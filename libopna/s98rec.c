@@ -0,0 +1,105 @@
+#include "s98rec.h"
+#include <string.h>
+
+enum {
+  S98REC_HEADER_SIZE = 0x30,
+  S98REC_OPNA_CLOCK = 7987200,
+  // s98gen overflows with much longer waits at one sync per sample
+  S98REC_MAX_WAIT = 1 << 16,
+};
+
+static void write32le(uint8_t *out, uint32_t x) {
+  out[0] = x;
+  out[1] = x >> 8;
+  out[2] = x >> 16;
+  out[3] = x >> 24;
+}
+
+static bool s98rec_flush(struct s98rec *rec) {
+  if (!rec->error && rec->buflen) {
+    if (!rec->write(rec->userptr, rec->buf, rec->buflen)) rec->error = true;
+  }
+  rec->buflen = 0;
+  return !rec->error;
+}
+
+static void s98rec_put(struct s98rec *rec, const uint8_t *data, size_t len) {
+  if (rec->buflen + len > sizeof(rec->buf)) s98rec_flush(rec);
+  memcpy(rec->buf + rec->buflen, data, len);
+  rec->buflen += len;
+}
+
+static void s98rec_wait(struct s98rec *rec) {
+  uint64_t frames = rec->opna->generated_frames;
+  while (rec->frames < frames) {
+    uint64_t wait = frames - rec->frames;
+    if (wait > S98REC_MAX_WAIT) wait = S98REC_MAX_WAIT;
+    rec->frames += wait;
+    if (wait == 1) {
+      s98rec_put(rec, (const uint8_t[]){0xff}, 1);
+      continue;
+    }
+    // 0xfe: wait - 2 in 7 bit little endian groups
+    uint8_t cmd[8] = {0xfe};
+    size_t len = 1;
+    uint32_t v = wait - 2;
+    do {
+      cmd[len] = v & 0x7f;
+      v >>= 7;
+      if (v) cmd[len] |= 0x80;
+      len++;
+    } while (v);
+    s98rec_put(rec, cmd, len);
+  }
+}
+
+bool s98rec_init(struct s98rec *rec, const struct opna *opna,
+                 s98rec_write_func write, void *userptr) {
+  rec->opna = opna;
+  rec->write = write;
+  rec->userptr = userptr;
+  rec->frames = opna->generated_frames;
+  rec->mode = 0;
+  rec->error = false;
+  rec->buflen = 0;
+
+  uint8_t header[S98REC_HEADER_SIZE] = {'S', '9', '8', '3'};
+  // timer: 144 / 7987200 seconds per sync
+  write32le(header + 0x04, 144);
+  write32le(header + 0x08, S98REC_OPNA_CLOCK);
+  // no tag, no loop
+  write32le(header + 0x14, S98REC_HEADER_SIZE);
+  write32le(header + 0x1c, 1);
+  // device 0: YM2608, no panning
+  write32le(header + 0x20, 4);
+  write32le(header + 0x24, S98REC_OPNA_CLOCK);
+  s98rec_put(rec, header, sizeof(header));
+  return s98rec_flush(rec);
+}
+
+void s98rec_writereg(void *recptr, unsigned reg, unsigned val) {
+  struct s98rec *rec = (struct s98rec *)recptr;
+  if (rec->error) return;
+  switch (reg) {
+  case 0x24:
+  case 0x25:
+  case 0x26:
+    // timer values, nothing to play back
+    return;
+  case 0x27:
+    // written on every timer interrupt, only the mode bits change the sound
+    val &= 0xc0;
+    if (val == rec->mode) return;
+    rec->mode = val;
+    break;
+  }
+  s98rec_wait(rec);
+  const uint8_t cmd[3] = {(reg >> 8) & 1, reg & 0xff, val};
+  s98rec_put(rec, cmd, sizeof(cmd));
+}
+
+bool s98rec_finish(struct s98rec *rec) {
+  s98rec_wait(rec);
+  s98rec_put(rec, (const uint8_t[]){0xfd}, 1);
+  return s98rec_flush(rec);
+}
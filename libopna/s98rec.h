@@ -0,0 +1,53 @@
+#ifndef MYON_S98REC_H_INCLUDED
+#define MYON_S98REC_H_INCLUDED
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "opna.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// streams OPNA register writes as an S98 (version 3, one YM2608) log
+// one sync is one OPNA sample (7987200/144 Hz), playable with s98gen
+// only the OPNA is recorded, PPZ8 output is not part of the log
+enum {
+  S98REC_BUF_SIZE = 4096,
+};
+
+// called with the file contents in order, returns false on error
+typedef bool (*s98rec_write_func)(void *userptr, const void *data, size_t len);
+
+struct s98rec {
+  const struct opna *opna;
+  s98rec_write_func write;
+  void *userptr;
+  // opna->generated_frames at the end of the last wait
+  uint64_t frames;
+  // CSM/channel 3 mode bits of 0x27, the timer bits are not recorded
+  uint8_t mode;
+  bool error;
+  size_t buflen;
+  uint8_t buf[S98REC_BUF_SIZE];
+};
+
+// writes the header, time starts at the current opna->generated_frames
+// to record everything the driver writes, call this and
+//   opna_timer_set_writereg_callback(timer, s98rec_writereg, rec)
+// after fmplayer_init_work_opna and before the file is loaded
+// returns false if writing the header failed
+bool s98rec_init(struct s98rec *rec, const struct opna *opna,
+                 s98rec_write_func write, void *userptr);
+// opna_timer_writereg_cb_t, recptr is struct s98rec *
+void s98rec_writereg(void *recptr, unsigned reg, unsigned val);
+// writes the wait up to the current opna->generated_frames and the end mark
+// returns false if any write failed
+bool s98rec_finish(struct s98rec *rec);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MYON_S98REC_H_INCLUDED
@@ -2,16 +2,62 @@
 #define MYON_FMPLAYER_OSCILLO_H_INCLUDED
 
 #include <stdint.h>
+#include <string.h>
 
 enum {
-  OSCILLO_SAMPLE_COUNT = 8192,
+  // also holds the samples rendered ahead of the audio output
+  OSCILLO_SAMPLE_COUNT = 16384,
+  OSCILLO_SAMPLE_MASK = OSCILLO_SAMPLE_COUNT - 1,
   OSCILLO_OFFSET_SHIFT = 10,
 };
 
+// buf is a ring buffer:
+// sample n is stored at buf[n & OSCILLO_SAMPLE_MASK]
+// and pos counts every sample ever written (wraps around)
 struct oscillodata {
   int16_t buf[OSCILLO_SAMPLE_COUNT];
   unsigned offset;
-  
+  // offset wraps around at period, 0 if the track has no pitch
+  unsigned period;
+  unsigned pos;
 };
 
+// copy the samples written to src since dst->pos into dst
+// (at most the whole ring when dst lags behind too far)
+static inline void oscillo_sync(struct oscillodata *dst, const struct oscillodata *src) {
+  unsigned count = src->pos - dst->pos;
+  if (count > OSCILLO_SAMPLE_COUNT) count = OSCILLO_SAMPLE_COUNT;
+  unsigned start = (src->pos - count) & OSCILLO_SAMPLE_MASK;
+  unsigned first = OSCILLO_SAMPLE_COUNT - start;
+  if (first > count) first = count;
+  memcpy(&dst->buf[start], &src->buf[start], first*sizeof(src->buf[0]));
+  memcpy(&dst->buf[0], &src->buf[0], (count-first)*sizeof(src->buf[0]));
+  dst->offset = src->offset;
+  dst->period = src->period;
+  dst->pos = src->pos;
+}
+
+// linearize the samples before the period-aligned point delay samples
+// before the end of the ring
+static inline void oscillo_window_delay(int16_t *dst, const struct oscillodata *src,
+                                        unsigned samples, unsigned delay) {
+  unsigned offset = src->offset;
+  if (src->period) {
+    unsigned d = ((uint64_t)delay << OSCILLO_OFFSET_SHIFT) % src->period;
+    offset = (offset + src->period - d) % src->period;
+  }
+  unsigned back = samples + delay + (offset >> OSCILLO_OFFSET_SHIFT);
+  if (back > OSCILLO_SAMPLE_COUNT) back = OSCILLO_SAMPLE_COUNT;
+  unsigned start = (src->pos - back) & OSCILLO_SAMPLE_MASK;
+  unsigned first = OSCILLO_SAMPLE_COUNT - start;
+  if (first > samples) first = samples;
+  memcpy(dst, &src->buf[start], first*sizeof(src->buf[0]));
+  memcpy(dst + first, &src->buf[0], (samples-first)*sizeof(src->buf[0]));
+}
+
+// linearize the last samples before the period-aligned end of the ring
+static inline void oscillo_window(int16_t *dst, const struct oscillodata *src, unsigned samples) {
+  oscillo_window_delay(dst, src, samples, 0);
+}
+
 #endif // MYON_FMPLAYER_OSCILLO_H_INCLUDED
@@ -47,6 +47,8 @@ pub fn build(b: *std.Build) void {
         "libopna/opnaadpcm.c",
         "libopna/opnatimer.c",
         "libopna/opnassg-sinc-c.c",
+        "libopna/opnacpu.c",
+        "libopna/opnafm-soa-c.c",
         "pacc/pacc-gl.c",
     }) catch @panic("OOM");
     switch (target.result.os.tag) {
@@ -82,24 +84,48 @@ pub fn build(b: *std.Build) void {
     if (enable_neon) {
         mod.addCMacro("ENABLE_NEON", "");
         files.append(b.allocator, "libopna/opnassg-sinc-neon.s") catch @panic("OOM");
+        files.append(b.allocator, "libopna/opnafm-soa-neon.c") catch @panic("OOM");
     }
     if (enable_sse) {
         mod.addCMacro("ENABLE_SSE", "");
         files.append(b.allocator, "libopna/opnassg-sinc-sse2.c") catch @panic("OOM");
+        files.append(b.allocator, "libopna/opnafm-soa-sse2.c") catch @panic("OOM");
+        files.append(b.allocator, "fmdriver/ppz8-sinc-sse2.c") catch @panic("OOM");
+        // newer kernels are always built, opna_cpu_select picks them at runtime
+        mod.addCMacro("ENABLE_AVX2", "");
+        mod.addCMacro("ENABLE_AVX512", "");
     }
+    const cflags = [_][]const u8{
+        "-std=c11",
+        "-Wall",
+        "-Wextra",
+        "-Werror",
+        // We can't use -pedantic due to casts for OpenGL function pointers from void*
+        "-Wno-unknown-attributes", // due to optimize attribute
+        "-fno-sanitize=shift",
+    };
     mod.addCSourceFiles(.{
         .root = b.path(".."),
         .files = files.items,
-        .flags = &.{
-            "-std=c11",
-            "-Wall",
-            "-Wextra",
-            "-Werror",
-            // We can't use -pedantic due to casts for OpenGL function pointers from void*
-            "-Wno-unknown-attributes", // due to optimize attribute
-            "-fno-sanitize=shift",
-        },
+        .flags = &cflags,
     });
+    if (enable_sse) {
+        mod.addCSourceFiles(.{
+            .root = b.path(".."),
+            .files = &.{
+                "libopna/opnassg-sinc-avx2.c",
+                "libopna/opnafm-soa-avx2.c",
+            },
+            .flags = &(cflags ++ [_][]const u8{"-mavx2"}),
+        });
+        mod.addCSourceFiles(.{
+            .root = b.path(".."),
+            .files = &.{
+                "libopna/opnassg-sinc-avx512.c",
+            },
+            .flags = &(cflags ++ [_][]const u8{ "-mavx512f", "-mavx512bw" }),
+        });
+    }
 
     const exe = b.addExecutable(.{
         .name = "98fmplayer",
@@ -7,6 +7,7 @@
 #include "fmdsp/font.h"
 #include "libopna/opna.h"
 #include "libopna/opnatimer.h"
+#include "libopna/opnacpu.h"
 #include "fmdriver/fmdriver.h"
 #include "common/fmplayer_file.h"
 #include "common/fmplayer_common.h"
@@ -243,12 +244,7 @@ static void handle_keydown(
 int main(int argc, char **argv) {
   (void)argc;
   (void)argv;
-#ifdef ENABLE_NEON
-  opna_ssg_sinc_calc_func = opna_ssg_sinc_calc_neon;
-#endif
-#ifdef ENABLE_SSE
-  opna_ssg_sinc_calc_func = opna_ssg_sinc_calc_sse2;
-#endif
+  opna_cpu_select();
   fft_init_table();
   if (!SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO)) {
     SDL_Log("Cannot initialize SDL\n");
@@ -0,0 +1,224 @@
+#include "aheadout.h"
+
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <semaphore.h>
+
+// renders ahead on its own thread into a single producer / single consumer
+// ring, the backend callback only copies from it
+// the ring is planar float so that float backends get the samples
+// as rendered, int16 backends convert while copying
+
+enum {
+  // frames rendered by one cbfunc call at most
+  BLOCK_FRAMES = 1024,
+  MIN_AHEAD_FRAMES = 256,
+};
+
+struct aheadout_state {
+  struct sound_state ss;
+  struct sound_state *backend;
+  sound_callback_f32 cbfunc;
+  void *userptr;
+  // planar stereo, ring_frames is a power of 2
+  float *ring[2];
+  unsigned ring_frames;
+  unsigned ahead_frames;
+  unsigned block_frames;
+  // frame counters, written only by the producer / consumer
+  atomic_uint wpos;
+  atomic_uint rpos;
+  // posted by the consumer, the producer waits on it when the ring is full
+  sem_t sem;
+  bool sem_valid;
+  atomic_bool paused;
+  atomic_bool terminate;
+  // held while cbfunc is called
+  atomic_flag cb_flag;
+  bool thread_valid;
+  pthread_t thread;
+};
+
+// render until ahead_frames frames are buffered
+// returns false if paused
+static bool aheadout_fill(struct aheadout_state *as) {
+  for (;;) {
+    while (atomic_flag_test_and_set_explicit(
+        &as->cb_flag, memory_order_acquire));
+    if (atomic_load_explicit(&as->paused, memory_order_relaxed)) {
+      atomic_flag_clear_explicit(&as->cb_flag, memory_order_release);
+      return false;
+    }
+    unsigned wpos = atomic_load_explicit(&as->wpos, memory_order_relaxed);
+    unsigned rpos = atomic_load_explicit(&as->rpos, memory_order_acquire);
+    unsigned space = as->ahead_frames - (wpos - rpos);
+    if (space < as->block_frames) {
+      atomic_flag_clear_explicit(&as->cb_flag, memory_order_release);
+      return true;
+    }
+    unsigned offset = wpos & (as->ring_frames - 1);
+    unsigned frames = as->block_frames;
+    if (frames > as->ring_frames - offset) frames = as->ring_frames - offset;
+    as->cbfunc(as->userptr, &as->ring[0][offset], &as->ring[1][offset], frames);
+    atomic_store_explicit(&as->wpos, wpos + frames, memory_order_release);
+    atomic_flag_clear_explicit(&as->cb_flag, memory_order_release);
+  }
+}
+
+static void *aheadout_thread(void *ptr) {
+  struct aheadout_state *as = ptr;
+  for (;;) {
+    sem_wait(&as->sem);
+    if (atomic_load_explicit(&as->terminate, memory_order_relaxed)) return 0;
+    while (!sem_trywait(&as->sem));
+    aheadout_fill(as);
+  }
+}
+
+// float rendered from int16 samples converts back to the same samples
+static int16_t aheadout_s16(float v) {
+  v *= 32768;
+  // round half away from zero without libm
+  int32_t o = v < 0 ? v - 0.5f : v + 0.5f;
+  if (o < INT16_MIN) o = INT16_MIN;
+  if (o > INT16_MAX) o = INT16_MAX;
+  return o;
+}
+
+// called on the audio thread, no locks
+static void aheadout_cb(void *userptr, int16_t *buf, unsigned frames) {
+  struct aheadout_state *as = userptr;
+  unsigned rpos = atomic_load_explicit(&as->rpos, memory_order_relaxed);
+  unsigned wpos = atomic_load_explicit(&as->wpos, memory_order_acquire);
+  unsigned avail = wpos - rpos;
+  unsigned copy = frames < avail ? frames : avail;
+  unsigned done = 0;
+  while (done < copy) {
+    unsigned offset = (rpos + done) & (as->ring_frames - 1);
+    unsigned n = copy - done;
+    if (n > as->ring_frames - offset) n = as->ring_frames - offset;
+    for (unsigned i = 0; i < n; i++) {
+      buf[(done+i)*2+0] = aheadout_s16(as->ring[0][offset+i]);
+      buf[(done+i)*2+1] = aheadout_s16(as->ring[1][offset+i]);
+    }
+    done += n;
+  }
+  // underrun
+  memset(&buf[copy*2], 0, (frames - copy) * 2 * sizeof(int16_t));
+  atomic_store_explicit(&as->rpos, rpos + copy, memory_order_release);
+  sem_post(&as->sem);
+}
+
+static void aheadout_cb_f32(void *userptr, float *l, float *r, unsigned frames) {
+  struct aheadout_state *as = userptr;
+  unsigned rpos = atomic_load_explicit(&as->rpos, memory_order_relaxed);
+  unsigned wpos = atomic_load_explicit(&as->wpos, memory_order_acquire);
+  unsigned avail = wpos - rpos;
+  unsigned copy = frames < avail ? frames : avail;
+  unsigned done = 0;
+  while (done < copy) {
+    unsigned offset = (rpos + done) & (as->ring_frames - 1);
+    unsigned n = copy - done;
+    if (n > as->ring_frames - offset) n = as->ring_frames - offset;
+    memcpy(&l[done], &as->ring[0][offset], n * sizeof(float));
+    memcpy(&r[done], &as->ring[1][offset], n * sizeof(float));
+    done += n;
+  }
+  // underrun
+  memset(&l[copy], 0, (frames - copy) * sizeof(float));
+  memset(&r[copy], 0, (frames - copy) * sizeof(float));
+  atomic_store_explicit(&as->rpos, rpos + copy, memory_order_release);
+  sem_post(&as->sem);
+}
+
+static void aheadout_pause(struct sound_state *ss, int pause, int flush) {
+  struct aheadout_state *as = (struct aheadout_state *)ss;
+  if (pause) {
+    as->backend->pause(as->backend, pause, flush);
+    atomic_store_explicit(&as->paused, true, memory_order_relaxed);
+    // wait for the producer to leave cbfunc
+    while (atomic_flag_test_and_set_explicit(
+        &as->cb_flag, memory_order_acquire));
+    atomic_flag_clear_explicit(&as->cb_flag, memory_order_release);
+  } else {
+    // neither the producer nor the consumer is running here
+    if (flush) {
+      atomic_store_explicit(&as->rpos,
+          atomic_load_explicit(&as->wpos, memory_order_relaxed),
+          memory_order_relaxed);
+    }
+    atomic_store_explicit(&as->paused, false, memory_order_relaxed);
+    // fill before starting so that playback does not start with an underrun
+    aheadout_fill(as);
+    as->backend->pause(as->backend, pause, flush);
+  }
+}
+
+static void aheadout_free(struct sound_state *ss) {
+  struct aheadout_state *as = (struct aheadout_state *)ss;
+  if (!as) return;
+  if (as->backend) as->backend->free(as->backend);
+  if (as->thread_valid) {
+    atomic_store_explicit(&as->terminate, true, memory_order_relaxed);
+    sem_post(&as->sem);
+    pthread_join(as->thread, 0);
+  }
+  if (as->sem_valid) sem_destroy(&as->sem);
+  free(as->ring[0]);
+  free(as->ring[1]);
+  free(as);
+}
+
+unsigned aheadout_buffered(struct sound_state *ss) {
+  struct aheadout_state *as = (struct aheadout_state *)ss;
+  unsigned rpos = atomic_load_explicit(&as->rpos, memory_order_relaxed);
+  unsigned wpos = atomic_load_explicit(&as->wpos, memory_order_relaxed);
+  unsigned latency = as->backend->latency ? as->backend->latency(as->backend) : 0;
+  return wpos - rpos + latency;
+}
+
+struct sound_state *aheadout_init(
+  const char *clientname, unsigned srate, unsigned minrate,
+  sound_callback_f32 cbfunc, void *userptr, unsigned ahead_frames) {
+  struct aheadout_state *as = malloc(sizeof(*as));
+  if (!as) return 0;
+  if (ahead_frames < MIN_AHEAD_FRAMES) ahead_frames = MIN_AHEAD_FRAMES;
+  unsigned ring_frames = 1;
+  while (ring_frames < ahead_frames) ring_frames <<= 1;
+  *as = (struct aheadout_state) {
+    .ss = {
+      .pause = aheadout_pause,
+      .free = aheadout_free,
+    },
+    .cbfunc = cbfunc,
+    .userptr = userptr,
+    .ring_frames = ring_frames,
+    .ahead_frames = ahead_frames,
+    .block_frames = ahead_frames/2 < BLOCK_FRAMES ? ahead_frames/2 : BLOCK_FRAMES,
+    .cb_flag = ATOMIC_FLAG_INIT,
+  };
+  atomic_init(&as->wpos, 0);
+  atomic_init(&as->rpos, 0);
+  atomic_init(&as->paused, true);
+  atomic_init(&as->terminate, false);
+  for (int c = 0; c < 2; c++) {
+    as->ring[c] = malloc(ring_frames * sizeof(float));
+    if (!as->ring[c]) goto err;
+  }
+  if (sem_init(&as->sem, 0, 0)) goto err;
+  as->sem_valid = true;
+  if (pthread_create(&as->thread, 0, aheadout_thread, as)) goto err;
+  as->thread_valid = true;
+  as->backend = sound_init(clientname, srate, minrate,
+                           aheadout_cb, aheadout_cb_f32, as);
+  if (!as->backend) goto err;
+  as->ss.apiname = as->backend->apiname;
+  as->ss.srate = as->backend->srate;
+  return &as->ss;
+err:
+  aheadout_free(&as->ss);
+  return 0;
+}
@@ -0,0 +1,12 @@
+#ifndef MYON_AHEADOUT_H_INCLUDED
+#define MYON_AHEADOUT_H_INCLUDED
+
+#include "soundout.h"
+
+// cbfunc renders at the rate of the backend (ss->srate, see sound_init)
+struct sound_state *aheadout_init(const char *clientname, unsigned srate, unsigned minrate, sound_callback_f32 cbfunc, void *userptr, unsigned ahead_frames);
+// frames rendered by cbfunc but not heard yet, in the ring and in the
+// backend, for delaying visualizations, can be called from any thread
+unsigned aheadout_buffered(struct sound_state *ss);
+
+#endif // MYON_AHEADOUT_H_INCLUDED
@@ -97,6 +97,14 @@ static void alsaout_pause(struct sound_state *ss, int pause, int flush) {
   (void)t;
 }
 
+static unsigned alsaout_latency(struct sound_state *ss) {
+  struct alsaout_state *as = (struct alsaout_state *)ss;
+  if (as->paused) return 0;
+  snd_pcm_sframes_t delay;
+  if (snd_pcm_delay(as->apcm, &delay) || delay < 0) return 0;
+  return delay;
+}
+
 static void alsaout_free(struct sound_state *ss) {
   if (!ss) return;
   struct alsaout_state *as = (struct alsaout_state *)ss;
@@ -127,7 +135,9 @@ struct sound_state *alsaout_init(
     .ss = {
       .pause = alsaout_pause,
       .free = alsaout_free,
+      .latency = alsaout_latency,
       .apiname = "ALSA",
+      .srate = srate,
     },
     .cbfunc = cbfunc,
     .userptr = userptr,
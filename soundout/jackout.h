@@ -3,7 +3,7 @@
 
 #include "soundout.h"
 
-struct sound_state *jackout_init(const char *clientname, unsigned srate, sound_callback cbfunc, void *userptr);
+// fails if the server rate is not between minrate and maxrate
+struct sound_state *jackout_init(const char *clientname, unsigned maxrate, unsigned minrate, sound_callback_f32 cbfunc, void *userptr);
 
 #endif // MYON_JACKOUT_H_INCLUDED
-
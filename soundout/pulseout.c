@@ -63,6 +63,18 @@ static void pulseout_pause(struct sound_state *ss, int pause, int flush) {
   }
 }
 
+static unsigned pulseout_latency(struct sound_state *ss) {
+  struct pulseout_state *ps = (struct pulseout_state *)ss;
+  if (ps->paused) return 0;
+  pa_usec_t usec;
+  int negative;
+  pa_threaded_mainloop_lock(ps->pa_tm);
+  int err = pa_stream_get_latency(ps->pa_s, &usec, &negative);
+  pa_threaded_mainloop_unlock(ps->pa_tm);
+  if (err || negative) return 0;
+  return (uint64_t)usec * ps->srate / (1000*1000);
+}
+
 static void pulseout_free(struct sound_state *ss) {
   struct pulseout_state *ps = (struct pulseout_state *)ss;
   if (ps) {
@@ -115,7 +127,9 @@ struct sound_state *pulseout_init(
     .ss = {
       .pause = pulseout_pause,
       .free = pulseout_free,
+      .latency = pulseout_latency,
       .apiname = "PulseAudio",
+      .srate = srate,
     },
     .cbfunc = cbfunc,
     .userptr = userptr,
@@ -163,7 +177,10 @@ struct sound_state *pulseout_init(
     .minreq = -1,
     .fragsize = -1,
   };
-  if (pa_stream_connect_playback(ps->pa_s, 0, &battr, PA_STREAM_ADJUST_LATENCY, 0, 0) < 0) goto err;
+  // timing updates for pulseout_latency
+  pa_stream_flags_t flags = PA_STREAM_ADJUST_LATENCY |
+      PA_STREAM_INTERPOLATE_TIMING | PA_STREAM_AUTO_TIMING_UPDATE;
+  if (pa_stream_connect_playback(ps->pa_s, 0, &battr, flags, 0, 0) < 0) goto err;
   return &ps->ss;
 err:
   pulseout_free(&ps->ss);
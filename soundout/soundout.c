@@ -3,10 +3,16 @@
 #include "pulseout.h"
 #include "alsaout.h"
 
-struct sound_state *sound_init(const char *clientname, unsigned srate, sound_callback cbfunc, void *userptr) {
+struct sound_state *sound_init(const char *clientname, unsigned srate, unsigned minrate,
+                               sound_callback cbfunc, sound_callback_f32 cbfunc_f32,
+                               void *userptr) {
+  // some are unused depending on the backends enabled
+  (void)minrate;
+  (void)cbfunc;
+  (void)cbfunc_f32;
   struct sound_state *ss = 0;
 #ifdef ENABLE_JACK
-  ss = jackout_init(clientname, srate, cbfunc, userptr);
+  if (cbfunc_f32) ss = jackout_init(clientname, srate, minrate, cbfunc_f32, userptr);
 #endif
   if (ss) return ss;
 #ifdef ENABLE_PULSE
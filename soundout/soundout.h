@@ -4,13 +4,26 @@
 #include <stdint.h>
 
 typedef void (*sound_callback)(void *userptr, int16_t *buf, unsigned frames);
+// planar float written (not added) to l and r, 1.0 is 32768
+typedef void (*sound_callback_f32)(void *userptr, float *l, float *r, unsigned frames);
 
 struct sound_state {
   void (*pause)(struct sound_state *state, int pause, int flush);
   void (*free)(struct sound_state *state);
   const char *apiname;
+  // rate the callback is called at
+  unsigned srate;
+  // frames passed to the backend but not heard yet, NULL if unknown
+  // can be called from any thread
+  unsigned (*latency)(struct sound_state *state);
 };
 
-struct sound_state *sound_init(const char *clientname, unsigned srate, sound_callback cbfunc, void *userptr);
+// backends that take float (JACK) call cbfunc_f32 straight from their
+// callback at the rate they run at, they are skipped if cbfunc_f32 is NULL
+// or that rate is not between minrate and srate
+// the others call cbfunc at srate
+struct sound_state *sound_init(const char *clientname, unsigned srate, unsigned minrate,
+                               sound_callback cbfunc, sound_callback_f32 cbfunc_f32,
+                               void *userptr);
 
 #endif // MYON_SOUNDOUT_H_INCLUDED
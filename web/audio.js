@@ -1,46 +1,45 @@
-import { imports as fileImports } from "./fmplayer_file_js.js";
-import { imports as platformImports } from "./fmdsp_platform_js.js";
-import { imports as paccImports } from "./pacc-js.js";
-import { imports as wasiImports } from "./wasi.js";
-
-const MAX_SAMPLES = 128;
-
 class AudioProcessor extends AudioWorkletProcessor {
-  /** @type {WebAssembly.Memory} */ memory;
-  /** @type {WebAssembly.Instance} */ wasm;
-
-  constructor({ processorOptions: { source, memory }}) {
+  constructor({ processorOptions: { memory, ring } }) {
     super();
 
-    const module = new WebAssembly.Module(source);
-    this.memory = memory;
-    this.wasm = new WebAssembly.Instance(module, {
-      env: { memory },
-      fmplayer_file: fileImports({}),
-      fmdsp_platform: platformImports(),
-      pacc: paccImports(memory, null),
-      wasi_snapshot_preview1: wasiImports(memory),
-    });
-    // Hacky way to have different stacks for the main "thread" and this worker:
-    // this worker gets the first half of the stack, and the main "thread" gets
-    // the second half. The stack is located at the beginning of memory.
-    this.wasm.exports.__stack_pointer.value /= 2;
+    // memory never grows (initial == maximum), so the views stay valid
+    this.wpos = new Int32Array(memory.buffer, ring.wpos, 1);
+    this.rpos = new Int32Array(memory.buffer, ring.rpos, 1);
+    this.flush = new Int32Array(memory.buffer, ring.flush, 1);
+    this.flushpos = new Int32Array(memory.buffer, ring.flushpos, 1);
+    this.left = new Float32Array(memory.buffer, ring.left, ring.frames);
+    this.right = new Float32Array(memory.buffer, ring.right, ring.frames);
+    this.frames = ring.frames;
   }
 
   process(_inputs, outputs, _parameters) {
     const output = outputs[0];
     const totalSamples = output[0].length;
+    let rpos = Atomics.load(this.rpos, 0);
+    // positions wrap around at 32 bits
+    // skip what was rendered before a song change or pause toggle
+    // flushpos was wpos at that time, so it is at most a ring ahead;
+    // it can be behind when a second flush came in since the exchange
+    if (Atomics.exchange(this.flush, 0, 0)) {
+      const flushpos = Atomics.load(this.flushpos, 0);
+      if (((flushpos - rpos) | 0) > 0) rpos = flushpos;
+    }
+    const available = (Atomics.load(this.wpos, 0) - rpos) | 0;
+    const samples = Math.min(totalSamples, available);
     let completedSamples = 0;
-    while (completedSamples < totalSamples) {
-      const blockSize = Math.min(totalSamples, MAX_SAMPLES);
-      this.wasm.exports.mix(blockSize);
-      const mixed = new DataView(this.memory.buffer, this.wasm.exports.getAudioBuf());
-      for (let i = 0; i < blockSize; i++) {
-        output[0][completedSamples + i] = mixed.getInt16(4 * i, true) / 32767;
-        output[1][completedSamples + i] = mixed.getInt16(4 * i + 2, true) / 32767;
-      }
+    while (completedSamples < samples) {
+      const offset = rpos & (this.frames - 1);
+      const blockSize = Math.min(samples - completedSamples, this.frames - offset);
+      output[0].set(this.left.subarray(offset, offset + blockSize), completedSamples);
+      output[1].set(this.right.subarray(offset, offset + blockSize), completedSamples);
       completedSamples += blockSize;
+      rpos += blockSize;
     }
+    // silence on underrun, never wait for the render worker
+    output[0].fill(0, completedSamples);
+    output[1].fill(0, completedSamples);
+    Atomics.store(this.rpos, 0, rpos);
+    Atomics.notify(this.rpos, 0);
     return true;
   }
 }
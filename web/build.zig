@@ -1,21 +1,31 @@
 const std = @import("std");
 
 pub fn build(b: *std.Build) void {
+    const enable_simd = b.option(
+        bool,
+        "simd",
+        "Use WebAssembly SIMD (simd128) kernels",
+    ) orelse true;
+
+    // See https://webassembly.org/features/ for support
+    var cpu_features = std.Target.wasm.featureSet(&.{
+        .atomics,
+        .bulk_memory,
+        .extended_const,
+        .multivalue,
+        .mutable_globals,
+        .nontrapping_fptoint,
+        .reference_types,
+        .sign_ext,
+        .tail_call,
+    });
+    if (enable_simd) {
+        cpu_features.addFeature(@intFromEnum(std.Target.wasm.Feature.simd128));
+    }
     const target = b.resolveTargetQuery(.{
         .cpu_arch = .wasm32,
         .cpu_model = .baseline,
-        .cpu_features_add = std.Target.wasm.featureSet(&.{
-            // See https://webassembly.org/features/ for support
-            .atomics,
-            .bulk_memory,
-            .extended_const,
-            .multivalue,
-            .mutable_globals,
-            .nontrapping_fptoint,
-            .reference_types,
-            .sign_ext,
-            .tail_call,
-        }),
+        .cpu_features_add = cpu_features,
         .os_tag = .wasi,
     });
     const optimize = b.standardOptimizeOption(.{});
@@ -36,32 +46,40 @@ pub fn build(b: *std.Build) void {
     mod.addIncludePath(b.path(".."));
     mod.addCMacro("_POSIX_C_SOURCE", "199309L");
     mod.addCMacro("LIBOPNA_ENABLE_LEVELDATA", "");
+    var files: std.ArrayList([]const u8) = .empty;
+    files.appendSlice(b.allocator, &.{
+        "common/fmplayer_drumrom_static.c",
+        "common/fmplayer_file.c",
+        "common/fmplayer_file_js.c",
+        "common/fmplayer_work_opna.c",
+        "libopna/opnaadpcm.c",
+        "libopna/opnadrum.c",
+        "libopna/opnafm.c",
+        "libopna/opnafm-soa-c.c",
+        "libopna/opnassg.c",
+        "libopna/opnassg-sinc-c.c",
+        "libopna/opnatimer.c",
+        "libopna/opna.c",
+        "fmdriver/fmdriver_fmp.c",
+        "fmdriver/fmdriver_pmd.c",
+        "fmdriver/fmdriver_common.c",
+        "fmdriver/ppz8.c",
+        "fft/fft.c",
+        "fmdsp/fmdsp-pacc.c",
+        "fmdsp/font_fmdsp_small.c",
+        "fmdsp/font_rom.c",
+        "fmdsp/fmdsp_platform_js.c",
+        "pacc/pacc-js.c",
+        "web/main.c",
+    }) catch @panic("OOM");
+    if (enable_simd) {
+        mod.addCMacro("ENABLE_WASM_SIMD", "");
+        files.append(b.allocator, "libopna/opnassg-sinc-wasm.c") catch @panic("OOM");
+        files.append(b.allocator, "fmdriver/ppz8-sinc-wasm.c") catch @panic("OOM");
+    }
     mod.addCSourceFiles(.{
         .root = b.path(".."),
-        .files = &.{
-            "common/fmplayer_drumrom_static.c",
-            "common/fmplayer_file.c",
-            "common/fmplayer_file_js.c",
-            "common/fmplayer_work_opna.c",
-            "libopna/opnaadpcm.c",
-            "libopna/opnadrum.c",
-            "libopna/opnafm.c",
-            "libopna/opnassg.c",
-            "libopna/opnassg-sinc-c.c",
-            "libopna/opnatimer.c",
-            "libopna/opna.c",
-            "fmdriver/fmdriver_fmp.c",
-            "fmdriver/fmdriver_pmd.c",
-            "fmdriver/fmdriver_common.c",
-            "fmdriver/ppz8.c",
-            "fft/fft.c",
-            "fmdsp/fmdsp-pacc.c",
-            "fmdsp/font_fmdsp_small.c",
-            "fmdsp/font_rom.c",
-            "fmdsp/fmdsp_platform_js.c",
-            "pacc/pacc-js.c",
-            "web/main.c",
-        },
+        .files = files.items,
         .flags = &.{
             "-Wall",
             "-Wextra",
@@ -89,6 +107,7 @@ pub fn build(b: *std.Build) void {
         "index.html",
         "index.js",
         "audio.js",
+        "render.js",
         "wasi.js",
         "../common/fmplayer_file_js.js",
         "../fmdsp/fmdsp_platform_js.js",
@@ -36,6 +36,9 @@ function render() {
 }
 requestAnimationFrame(render);
 
+const renderWorker = new Worker("render.js", { type: "module" });
+renderWorker.postMessage({ source, memory });
+
 const audioCtx = new AudioContext({
   sampleRate: 55467,
 });
@@ -44,7 +47,18 @@ const audioNode = new AudioWorkletNode(audioCtx, "audio", {
   numberOfInputs: 0,
   numberOfOutputs: 1,
   outputChannelCount: [2],
-  processorOptions: { source, memory },
+  processorOptions: {
+    memory,
+    ring: {
+      wpos: wasm.exports.getRingWpos(),
+      rpos: wasm.exports.getRingRpos(),
+      flush: wasm.exports.getRingFlush(),
+      flushpos: wasm.exports.getRingFlushpos(),
+      left: wasm.exports.getRingL(),
+      right: wasm.exports.getRingR(),
+      frames: wasm.exports.getRingFrames(),
+    },
+  },
 });
 audioNode.connect(audioCtx.destination);
 
@@ -18,7 +18,11 @@
 #define EXPORT(name) __attribute__((export_name(name)))
 
 enum {
-  MAX_SAMPLES = 128,
+  // frames rendered at once by the render worker
+  RENDER_FRAMES = 128,
+  // render-ahead ring read by the AudioWorklet, power of 2
+  RING_FRAMES = 4096,
+  RENDER_STACK_SIZE = 256 * 1024,
 };
 
 static struct {
@@ -37,7 +41,20 @@ static struct {
   struct pacc_ctx *pc;
   struct pacc_vtable pacc;
   struct fmdsp_pacc *fp;
-  int16_t audio_buf[MAX_SAMPLES * 2];
+  // single producer (render worker), single consumer (AudioWorklet)
+  // the AudioWorklet only copies from here and never waits
+  struct {
+    // free running frame counts, wpos - rpos frames are readable
+    atomic_uint wpos;
+    atomic_uint rpos;
+    // set with flushpos by ring_flush, the AudioWorklet (which owns rpos)
+    // clears it and skips the frames before flushpos
+    // positions wrap around, so flushpos is only compared while it is fresh
+    atomic_int flush;
+    atomic_uint flushpos;
+    float l[RING_FRAMES];
+    float r[RING_FRAMES];
+  } ring;
 } g = {
   .opna_flag = ATOMIC_FLAG_INIT,
   .at_fftdata_flag = ATOMIC_FLAG_INIT,
@@ -66,8 +83,18 @@ EXPORT("getFilenameBuf") char *fmplayer_web_get_filename_buf(void) {
   return g.filename_buf;
 }
 
+// drops the frames rendered so far, so that a song change or pause
+// is heard at once and not after the whole ring
+// called with opna_flag held, under which wpos is advanced
+static void ring_flush(void) {
+  unsigned wpos = atomic_load_explicit(&g.ring.wpos, memory_order_relaxed);
+  atomic_store_explicit(&g.ring.flushpos, wpos, memory_order_relaxed);
+  atomic_store_explicit(&g.ring.flush, 1, memory_order_release);
+}
+
 EXPORT("loadFile") bool fmplayer_web_load_file(void) {
   while (atomic_flag_test_and_set_explicit(&g.opna_flag, memory_order_acquire));
+  ring_flush();
   if (g.fmfile) fmplayer_file_free(g.fmfile);
   memset(g.adpcm_ram, 0, sizeof(g.adpcm_ram));
   fmplayer_init_work_opna(&g.work, &g.ppz8, &g.opna, &g.opna_timer, g.adpcm_ram);
@@ -102,8 +129,39 @@ EXPORT("render") void fmplayer_web_render(void) {
   fmdsp_pacc_render(g.fp);
 }
 
-EXPORT("getAudioBuf") int16_t *fmplayer_web_get_audio_buf(void) {
-  return g.audio_buf;
+// every instance sharing the memory needs its own stack
+static uint8_t render_stack[RENDER_STACK_SIZE] __attribute__((aligned(16)));
+
+EXPORT("getRenderStackTop") uint8_t *fmplayer_web_get_render_stack_top(void) {
+  return render_stack + RENDER_STACK_SIZE;
+}
+
+EXPORT("getRingFrames") unsigned fmplayer_web_get_ring_frames(void) {
+  return RING_FRAMES;
+}
+
+EXPORT("getRingWpos") atomic_uint *fmplayer_web_get_ring_wpos(void) {
+  return &g.ring.wpos;
+}
+
+EXPORT("getRingRpos") atomic_uint *fmplayer_web_get_ring_rpos(void) {
+  return &g.ring.rpos;
+}
+
+EXPORT("getRingFlush") atomic_int *fmplayer_web_get_ring_flush(void) {
+  return &g.ring.flush;
+}
+
+EXPORT("getRingFlushpos") atomic_uint *fmplayer_web_get_ring_flushpos(void) {
+  return &g.ring.flushpos;
+}
+
+EXPORT("getRingL") float *fmplayer_web_get_ring_l(void) {
+  return g.ring.l;
+}
+
+EXPORT("getRingR") float *fmplayer_web_get_ring_r(void) {
+  return g.ring.r;
 }
 
 EXPORT("playing") bool fmplayer_web_playing(void) {
@@ -111,23 +169,50 @@ EXPORT("playing") bool fmplayer_web_playing(void) {
 }
 
 EXPORT("togglePaused") void fmplayer_web_toggle_paused(void) {
+  while (atomic_flag_test_and_set_explicit(&g.opna_flag, memory_order_acquire));
+  ring_flush();
   g.work.paused = !g.work.paused;
+  atomic_flag_clear_explicit(&g.opna_flag, memory_order_release);
 }
 
 EXPORT("commentScroll") void fmplayer_web_comment_scroll(bool down) {
   fmdsp_pacc_comment_scroll(g.fp, down);
 }
 
-EXPORT("mix") void fmplayer_web_mix(size_t samples) {
-  memset(g.audio_buf, 0, sizeof(g.audio_buf));
+// renders RENDER_FRAMES frames at wpos into the ring and publishes them
+static void mix(unsigned wpos) {
+  // RING_FRAMES is a multiple of RENDER_FRAMES, no wraparound inside
+  float *l = &g.ring.l[wpos % RING_FRAMES];
+  float *r = &g.ring.r[wpos % RING_FRAMES];
+  unsigned samples = RENDER_FRAMES;
+  // only contended by loadFile and togglePaused, which run on the main thread
   while (atomic_flag_test_and_set_explicit(&g.opna_flag, memory_order_acquire));
   if (!g.work.paused) {
-    opna_timer_mix(&g.opna_timer, g.audio_buf, samples);
+    opna_timer_mix_f32(&g.opna_timer, l, r, samples);
+  } else {
+    memset(l, 0, samples * sizeof(*l));
+    memset(r, 0, samples * sizeof(*r));
   }
+  // published before unlocking, so ring_flush drops all of these frames or none
+  atomic_store_explicit(&g.ring.wpos, wpos + samples, memory_order_release);
   atomic_flag_clear_explicit(&g.opna_flag, memory_order_release);
 
   if (!atomic_flag_test_and_set_explicit(&g.at_fftdata_flag, memory_order_acquire)) {
-    fft_write(&g.at_fftdata, g.audio_buf, samples);
+    fft_write_f32(&g.at_fftdata, l, r, samples);
     atomic_flag_clear_explicit(&g.at_fftdata_flag, memory_order_release);
   }
 }
+
+// runs forever on the render worker
+EXPORT("renderAhead") void fmplayer_web_render_ahead(void) {
+  for (;;) {
+    unsigned wpos = atomic_load_explicit(&g.ring.wpos, memory_order_relaxed);
+    unsigned rpos = atomic_load_explicit(&g.ring.rpos, memory_order_acquire);
+    if (wpos - rpos > RING_FRAMES - RENDER_FRAMES) {
+      // the AudioWorklet notifies rpos after every read
+      __builtin_wasm_memory_atomic_wait32((int *)&g.ring.rpos, (int)rpos, -1);
+      continue;
+    }
+    mix(wpos);
+  }
+}
@@ -0,0 +1,21 @@
+import { imports as fileImports } from "./fmplayer_file_js.js";
+import { imports as platformImports } from "./fmdsp_platform_js.js";
+import { imports as paccImports } from "./pacc-js.js";
+import { imports as wasiImports } from "./wasi.js";
+
+// Renders ahead into the ring in wasm memory, read by the AudioWorklet.
+// This worker blocks in renderAhead and never handles another message.
+self.addEventListener("message", ({ data: { source, memory } }) => {
+  const module = new WebAssembly.Module(source);
+  const wasm = new WebAssembly.Instance(module, {
+    env: { memory },
+    fmplayer_file: fileImports({}),
+    fmdsp_platform: platformImports(),
+    pacc: paccImports(memory, null),
+    wasi_snapshot_preview1: wasiImports(memory),
+  });
+  // The main thread instance uses the stack set up by the linker,
+  // this one gets a separate stack reserved in the module.
+  wasm.exports.__stack_pointer.value = wasm.exports.getRenderStackTop();
+  wasm.exports.renderAhead();
+}, { once: true });
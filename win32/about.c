@@ -20,6 +20,7 @@ static struct {
   HFONT font, font_large, font_small;
   HWND static_main, static_icon, static_help, static_info, button_ok;
   wchar_t *soundapiname;
+  wchar_t simdname[16];
   bool adpcm_rom, font_rom;
 } g;
 
@@ -42,18 +43,11 @@ static void update_status(void) {
            L"Audio API: %ls\r\n"
            "ym2608_adpcm_rom.bin: %lsavailable\r\n"
            "font.rom: %ls\r\n"
-           "Vector acceleration (for SIMD SSG resampling): %ls",
+           "SSG resampler kernel: %ls",
            g.soundapiname ? g.soundapiname : L"",
            g.adpcm_rom ? L"" : L"un",
            g.font_rom ? L"available" : L"unavailable, using MS Gothic",
-#if defined(ENABLE_NEON)
-           L"Neon",
-#elif defined(ENABLE_SSE)
-           L"SSE"
-#else
-           L"unavailable"
-#endif
-           );
+           g.simdname);
   SetWindowText(g.static_info, buf);
 }
 
@@ -201,6 +195,16 @@ void about_set_adpcmrom_loaded(bool loaded) {
   if (g.about) update_status();
 }
 
+void about_set_simdname(const char *name) {
+  // kernel names are ASCII
+  size_t i = 0;
+  for (; name[i] && i < sizeof(g.simdname)/sizeof(g.simdname[0]) - 1; i++) {
+    g.simdname[i] = name[i];
+  }
+  g.simdname[i] = 0;
+  if (g.about) update_status();
+}
+
 void about_close(void) {
   if (g.about) {
     g.closecb = 0;
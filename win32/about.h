@@ -10,5 +10,6 @@ void about_close(void);
 void about_setsoundapiname(const wchar_t *apiname);
 void about_set_fontrom_loaded(bool loaded);
 void about_set_adpcmrom_loaded(bool loaded);
+void about_set_simdname(const char *name);
 
 #endif // MYON_FMPLAYER_WIN32_ABOUT_H_INCLUDED
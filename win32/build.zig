@@ -61,6 +61,8 @@ pub fn build(b: *std.Build) void {
         "libopna/opnafm.c",
         "libopna/opnassg.c",
         "libopna/opnassg-sinc-c.c",
+        "libopna/opnacpu.c",
+        "libopna/opnafm-soa-c.c",
         "libopna/opnadrum.c",
         "libopna/opnaadpcm.c",
         "pacc/pacc-d3d9.c",
@@ -69,26 +71,50 @@ pub fn build(b: *std.Build) void {
     if (enable_neon) {
         mod.addCMacro("ENABLE_NEON", "");
         files.append(b.allocator, "libopna/opnassg-sinc-neon.s") catch @panic("OOM");
+        files.append(b.allocator, "libopna/opnafm-soa-neon.c") catch @panic("OOM");
     }
     if (enable_sse) {
         mod.addCMacro("ENABLE_SSE", "");
         files.append(b.allocator, "libopna/opnassg-sinc-sse2.c") catch @panic("OOM");
+        files.append(b.allocator, "libopna/opnafm-soa-sse2.c") catch @panic("OOM");
+        files.append(b.allocator, "fmdriver/ppz8-sinc-sse2.c") catch @panic("OOM");
+        // newer kernels are always built, opna_cpu_select picks them at runtime
+        mod.addCMacro("ENABLE_AVX2", "");
+        mod.addCMacro("ENABLE_AVX512", "");
     }
+    const cflags = [_][]const u8{
+        "-std=c11",
+        "-Wall",
+        "-Wextra",
+        "-Werror",
+        "-pedantic",
+        "-Wno-cast-function-type-mismatch", // due to proc address cast in pacc-d3d9.c
+        "-Wno-unknown-attributes", // due to optimize attribute
+        "-Wno-unused-function", // TODO: in fmplayer_file_win.c
+        "-fno-sanitize=shift",
+    };
     mod.addCSourceFiles(.{
         .root = b.path(".."),
         .files = files.items,
-        .flags = &.{
-            "-std=c11",
-            "-Wall",
-            "-Wextra",
-            "-Werror",
-            "-pedantic",
-            "-Wno-cast-function-type-mismatch", // due to proc address cast in pacc-d3d9.c
-            "-Wno-unknown-attributes", // due to optimize attribute
-            "-Wno-unused-function", // TODO: in fmplayer_file_win.c
-            "-fno-sanitize=shift",
-        },
+        .flags = &cflags,
     });
+    if (enable_sse) {
+        mod.addCSourceFiles(.{
+            .root = b.path(".."),
+            .files = &.{
+                "libopna/opnassg-sinc-avx2.c",
+                "libopna/opnafm-soa-avx2.c",
+            },
+            .flags = &(cflags ++ [_][]const u8{"-mavx2"}),
+        });
+        mod.addCSourceFiles(.{
+            .root = b.path(".."),
+            .files = &.{
+                "libopna/opnassg-sinc-avx512.c",
+            },
+            .flags = &(cflags ++ [_][]const u8{ "-mavx512f", "-mavx512bw" }),
+        });
+    }
 
     const icotool_run = b.addSystemCommand(&.{ "icotool", "-c" });
     icotool_run.addFileArg(b.path("fmplayer.png"));
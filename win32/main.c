@@ -12,6 +12,7 @@
 #include "common/fmplayer_file.h"
 #include "libopna/opna.h"
 #include "libopna/opnatimer.h"
+#include "libopna/opnacpu.h"
 #include "soundout.h"
 #include "version.h"
 #include "toneview.h"
@@ -106,7 +107,9 @@ static void sound_cb(void *p, int16_t *buf, unsigned frames) {
   }
   if (!atomic_flag_test_and_set_explicit(
     &oscilloview_g.flag, memory_order_acquire)) {
-    memcpy(oscilloview_g.oscillodata, g.oscillodata_audiothread, sizeof(oscilloview_g.oscillodata));
+    for (int i = 0; i < LIBOPNA_OSCILLO_TRACK_COUNT; i++) {
+      oscillo_sync(&oscilloview_g.oscillodata[i], &g.oscillodata_audiothread[i]);
+    }
     atomic_flag_clear_explicit(&oscilloview_g.flag, memory_order_release);
   }
   if (!atomic_flag_test_and_set_explicit(
@@ -771,12 +774,7 @@ int CALLBACK wWinMain(HINSTANCE hinst, HINSTANCE hpinst,
   (void)hpinst;
   (void)cmdline_;
 
-#ifdef ENABLE_NEON
-  opna_ssg_sinc_calc_func = opna_ssg_sinc_calc_neon;
-#endif
-#ifdef ENABLE_SSE
-  opna_ssg_sinc_calc_func = opna_ssg_sinc_calc_sse2;
-#endif
+  about_set_simdname(opna_cpu_select());
 
   fft_init_table();
   about_set_fontrom_loaded(fmplayer_font_rom_load(&g.font));
@@ -14,6 +14,7 @@ struct oscilloview oscilloview_g = {
 enum {
   VIEW_SAMPLES = 1024,
   VIEW_SKIP = 2,
+  VIEW_TRACKS = 9,
 };
 
 static struct {
@@ -21,7 +22,7 @@ static struct {
   HWND parent;
   HWND oscilloview;
   ATOM oscilloview_class;
-  struct oscillodata oscillodata[LIBOPNA_OSCILLO_TRACK_COUNT];
+  int16_t viewdata[VIEW_TRACKS][VIEW_SAMPLES];
   UINT mmtimer;
   HPEN whitepen;
   void (*closecb)(void *ptr);
@@ -59,13 +60,10 @@ static bool on_create(HWND hwnd, const CREATESTRUCT *cs) {
 
 static void draw_track(HDC dc,
                        int x, int y, int w, int h,
-                       const struct oscillodata *data) {
-  int start = OSCILLO_SAMPLE_COUNT - VIEW_SAMPLES;
-  start -= (data->offset >> OSCILLO_OFFSET_SHIFT);
-  if (start < 0) start = 0;
-  MoveToEx(dc, x, y + h/2.0 - (data->buf[start] / 16384.0) * h/2, 0);
+                       const int16_t *data) {
+  MoveToEx(dc, x, y + h/2.0 - (data[0] / 16384.0) * h/2, 0);
   for (int i = 0; i < (VIEW_SAMPLES / VIEW_SKIP); i++) {
-    LineTo(dc, (double)x + ((i)*w)/(VIEW_SAMPLES / VIEW_SKIP), y + h/2.0 - (data->buf[start + i*VIEW_SKIP] / 16384.0) * h/2);
+    LineTo(dc, (double)x + ((i)*w)/(VIEW_SAMPLES / VIEW_SKIP), y + h/2.0 - (data[i*VIEW_SKIP] / 16384.0) * h/2);
   }
 }
 
@@ -84,7 +82,7 @@ static void on_paint(HWND hwnd) {
   int height = cr.bottom / 3;
   for (int x = 0; x < 3; x++) {
     for (int y = 0; y < 3; y++) {
-      draw_track(mdc, x*width, y*height, width, height, &g.oscillodata[x*3+y]);
+      draw_track(mdc, x*width, y*height, width, height, g.viewdata[x*3+y]);
     }
   }
 
@@ -108,9 +106,9 @@ static LRESULT CALLBACK wndproc(
   case WM_USER:
     if (!atomic_flag_test_and_set_explicit(
       &oscilloview_g.flag, memory_order_acquire)) {
-      memcpy(g.oscillodata,
-             oscilloview_g.oscillodata,
-             sizeof(oscilloview_g.oscillodata));
+      for (int i = 0; i < VIEW_TRACKS; i++) {
+        oscillo_window(g.viewdata[i], &oscilloview_g.oscillodata[i], VIEW_SAMPLES);
+      }
       atomic_flag_clear_explicit(&oscilloview_g.flag, memory_order_release);
     }
     InvalidateRect(hwnd, 0, FALSE);